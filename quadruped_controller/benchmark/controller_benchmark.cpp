@@ -0,0 +1,275 @@
+/**
+ * @file controller_benchmark.cpp
+ * @date 2021-10-09
+ * @author Boston Cleek
+ * @brief Hot path latency benchmarks for the controller library
+ *
+ * @details Each benchmark reports the median and p99 latency across
+ * repetitions. Inputs are the standing configuration defaults used by
+ * the commander node so the numbers are comparable commit to commit.
+ */
+
+// C++
+#include <algorithm>
+#include <vector>
+
+// Google Benchmark
+#include <benchmark/benchmark.h>
+
+// Quadruped Control
+#include <quadruped_controller/balance_controller.hpp>
+#include <quadruped_controller/foot_planner.hpp>
+#include <quadruped_controller/gait.hpp>
+#include <quadruped_controller/kinematics.hpp>
+#include <quadruped_controller/trajectory.hpp>
+
+namespace
+{
+using arma::eye;
+using arma::mat;
+using arma::vec;
+using arma::vec3;
+
+using namespace quadruped_controller;
+
+// IMPORTANT: Most of the software has been configured to run
+//            with these joint names and in this order
+const std::vector<std::string> leg_names = { "RL", "FL", "RR", "FR" };
+
+// Dynamic properties (mit_cheetah_config.yaml)
+constexpr double mu = 0.8;       // coefficient of friction
+constexpr double mass = 11.0;    // total mass (kg)
+constexpr double fzmin = 10.0;   // min z-axis ground reaction force (N)
+constexpr double fzmax = 120.0;  // max z-axis ground reaction force (N)
+
+// Gait (mit_cheetah_config.yaml)
+constexpr double t_stance = 0.8;   // stance time (s)
+constexpr double t_swing = 0.18;   // swing time (s)
+constexpr double height = 0.08;    // max foot height (m)
+
+/** @brief Report the median and p99 latency across repetitions */
+void latencyStatistics(benchmark::internal::Benchmark* b)
+{
+  b->Repetitions(20);
+  b->ReportAggregatesOnly(true);
+  b->ComputeStatistics("p99", [](const std::vector<double>& samples) {
+    std::vector<double> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+    return sorted.at(static_cast<unsigned int>(0.99 * (sorted.size() - 1)));
+  });
+}
+
+/** @brief Joint states in the standing configuration */
+JointStatesMap standingJointStates()
+{
+  JointStatesMap joint_states_map;
+  for (const auto& leg_name : leg_names)
+  {
+    LegJointStates leg;
+    leg.q = { 0.0, 1.61, -2.78 };
+    leg.qdot.zeros();
+    joint_states_map.emplace(leg_name, leg);
+  }
+
+  return joint_states_map;
+}
+
+/** @brief Gait schedule with the diagonal legs in swing phase */
+GaitMap swingGaitMap()
+{
+  GaitMap gait_map;
+  gait_map.emplace("RL", std::make_pair(LegState::stance, 0.4));
+  gait_map.emplace("FL", std::make_pair(LegState::swing, 0.9));
+  gait_map.emplace("RR", std::make_pair(LegState::swing, 0.9));
+  gait_map.emplace("FR", std::make_pair(LegState::stance, 0.4));
+
+  return gait_map;
+}
+
+/** @brief Balance controller with the deployment gains */
+BalanceController makeBalanceController()
+{
+  const mat Ib = arma::diagmat(vec({ 0.011253, 0.036203, 0.042673 }));
+  const mat S = arma::diagmat(vec({ 1.0, 1.0, 1.0, 10.0, 10.0, 5.0 }));
+  const mat W = eye(12, 12) * 1e-5;
+
+  const vec kff = { 0.0, 0.0, 0.15, 0.0, 0.0, 0.0 };
+  const vec kp_p = { 100.0, 100.0, 100.0 };
+  const vec kd_p = { 50.0, 50.0, 50.0 };
+  const vec kp_w = { 5000.0, 5000.0, 5000.0 };
+  const vec kd_w = { 500.0, 500.0, 500.0 };
+
+  return BalanceController(mu, mass, fzmin, fzmax, Ib, S, W, kff, kp_p, kd_p, kp_w,
+                           kd_w, leg_names);
+}
+
+// Standing state defaults from the commander node
+const mat Rwb = eye(3, 3);
+const mat Rwb_d = eye(3, 3);
+const vec3 x = { 0.0, 0.0, 0.25 };
+const vec3 x_d = { 0.0, 0.0, 0.26 };
+const vec3 xdot(arma::fill::zeros);
+const vec3 xdot_d(arma::fill::zeros);
+const vec3 w(arma::fill::zeros);
+const vec3 w_d(arma::fill::zeros);
+
+void BM_BalanceControllerInit(benchmark::State& state)
+{
+  const QuadrupedKinematics kinematics;
+  const FootholdMap foot_map = kinematics.forwardKinematics(standingJointStates());
+  const GaitMap gait_map = make_stance_gait();
+
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    const BalanceController balance_controller = makeBalanceController();
+    state.ResumeTiming();
+
+    // First solve always takes the cold init path
+    const ForceMap force_map = balance_controller.control(Rwb, Rwb_d, x, xdot, w, x_d,
+                                                          xdot_d, w_d, foot_map, gait_map);
+    benchmark::DoNotOptimize(force_map);
+  }
+}
+BENCHMARK(BM_BalanceControllerInit)->Apply(latencyStatistics);
+
+void BM_BalanceControllerHotstart(benchmark::State& state)
+{
+  const BalanceController balance_controller = makeBalanceController();
+  const QuadrupedKinematics kinematics;
+  const FootholdMap foot_map = kinematics.forwardKinematics(standingJointStates());
+  const GaitMap gait_map = make_stance_gait();
+
+  // Warm up so every timed solve hotstarts from the previous solution
+  balance_controller.control(Rwb, Rwb_d, x, xdot, w, x_d, xdot_d, w_d, foot_map,
+                             gait_map);
+
+  ForceMap force_map;
+  for (auto _ : state)
+  {
+    balance_controller.control(Rwb, Rwb_d, x, xdot, w, x_d, xdot_d, w_d, foot_map,
+                               gait_map, force_map);
+    benchmark::DoNotOptimize(force_map);
+  }
+}
+BENCHMARK(BM_BalanceControllerHotstart)->Apply(latencyStatistics);
+
+void BM_ForwardKinematics(benchmark::State& state)
+{
+  const QuadrupedKinematics kinematics;
+  const JointStatesMap joint_states_map = standingJointStates();
+
+  for (auto _ : state)
+  {
+    const FootholdMap foot_map = kinematics.forwardKinematics(joint_states_map);
+    benchmark::DoNotOptimize(foot_map);
+  }
+}
+BENCHMARK(BM_ForwardKinematics)->Apply(latencyStatistics);
+
+void BM_LegInverseKinematics(benchmark::State& state)
+{
+  const QuadrupedKinematics kinematics;
+  const vec3 q = { 0.0, 1.61, -2.78 };
+  const vec3 foothold = kinematics.forwardKinematics("FL", q);
+
+  for (auto _ : state)
+  {
+    const vec3 joints = kinematics.legInverseKinematics("FL", foothold);
+    benchmark::DoNotOptimize(joints);
+  }
+}
+BENCHMARK(BM_LegInverseKinematics)->Apply(latencyStatistics);
+
+void BM_LegJacobianInverse(benchmark::State& state)
+{
+  const QuadrupedKinematics kinematics;
+  const vec3 q = { 0.0, 1.61, -2.78 };
+
+  for (auto _ : state)
+  {
+    const mat33 Jinv = kinematics.legJacobianInverse("FL", q);
+    benchmark::DoNotOptimize(Jinv);
+  }
+}
+BENCHMARK(BM_LegJacobianInverse)->Apply(latencyStatistics);
+
+void BM_FootTrajectoryGenerate(benchmark::State& state)
+{
+  const FootTrajectory foot_trajectory;
+
+  // Swing trajectory bounds for a standing FL foot stepping forward
+  const vec3 p_start = { 0.196, 0.11, 0.0 };
+  const vec3 p_final = { 0.296, 0.11, 0.0 };
+  const vec3 p_center = { 0.246, 0.11, height };
+
+  for (auto _ : state)
+  {
+    const bool success = foot_trajectory.generateTrajetory(p_start, p_center, p_final);
+    benchmark::DoNotOptimize(success);
+  }
+}
+BENCHMARK(BM_FootTrajectoryGenerate)->Apply(latencyStatistics);
+
+void BM_FootTrajectoryTrack(benchmark::State& state)
+{
+  const FootTrajectory foot_trajectory;
+
+  const vec3 p_start = { 0.196, 0.11, 0.0 };
+  const vec3 p_final = { 0.296, 0.11, 0.0 };
+  const vec3 p_center = { 0.246, 0.11, height };
+  foot_trajectory.generateTrajetory(p_start, p_center, p_final);
+
+  auto t = 0.0;
+  for (auto _ : state)
+  {
+    const FootState foot_state = foot_trajectory.trackTrajectory(t);
+    benchmark::DoNotOptimize(foot_state);
+
+    t += 0.01;
+    if (t > 1.0)
+    {
+      t = 0.0;
+    }
+  }
+}
+BENCHMARK(BM_FootTrajectoryTrack)->Apply(latencyStatistics);
+
+void BM_GaitSchedulerSchedule(benchmark::State& state)
+{
+  const vec phase_offset = { 0.0, 0.5, 0.5, 0.0 };
+  const GaitScheduler gait_scheduler(t_swing, t_stance, phase_offset);
+  gait_scheduler.start();
+
+  for (auto _ : state)
+  {
+    const GaitMap gait_map = gait_scheduler.schedule();
+    benchmark::DoNotOptimize(gait_map);
+  }
+}
+BENCHMARK(BM_GaitSchedulerSchedule)->Apply(latencyStatistics);
+
+void BM_FootPlannerPositions(benchmark::State& state)
+{
+  const FootPlanner foothold_planner;
+  const QuadrupedKinematics kinematics;
+  const FootholdMap foot_map = kinematics.forwardKinematics(standingJointStates());
+
+  // Alternate the schedule so every other call plans new footholds
+  const GaitMap stance_map = make_stance_gait();
+  const GaitMap swing_map = swingGaitMap();
+
+  auto planning = false;
+  for (auto _ : state)
+  {
+    const auto foothold_plan = foothold_planner.positions(
+        t_stance, Rwb, x, xdot, w, xdot_d, foot_map, planning ? swing_map : stance_map);
+    benchmark::DoNotOptimize(foothold_plan);
+
+    planning = !planning;
+  }
+}
+BENCHMARK(BM_FootPlannerPositions)->Apply(latencyStatistics);
+}  // namespace
+
+BENCHMARK_MAIN();
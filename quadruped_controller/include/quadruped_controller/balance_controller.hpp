@@ -12,11 +12,10 @@
 
 #include <quadruped_controller/math/rigid3d.hpp>
 #include <quadruped_controller/gait.hpp>
+#include <quadruped_controller/qp_backend.hpp>
 
 namespace quadruped_controller
 {
-using std::tuple;
-
 using arma::eye;
 using arma::mat;
 using arma::vec;
@@ -28,7 +27,6 @@ using math::skew_symmetric;
 using qpOASES::Options;
 using qpOASES::real_t;
 using qpOASES::returnValue;
-using qpOASES::SQProblem;
 
 /**
  * @brief Copy vector to array
@@ -44,6 +42,15 @@ void copy_to_real_t(const vec& source, real_t* target);
  */
 void copy_to_real_t(const mat& source, real_t* target);
 
+/**
+ * @brief Copy a symmetric matrix to an array without a transpose
+ * @param source - symmetric matrix
+ * @param target[out] - array containing same contents as the source
+ * @details Row-major and column-major layouts coincide for symmetric
+ * matrices so the handoff is a single bulk copy.
+ */
+void copy_to_real_t_symmetric(const mat& source, real_t* target);
+
 /**
  * @brief Copy array to vector
  * @param source - array
@@ -106,6 +113,27 @@ public:
                    const FootholdMap& foot_map,
                    const GaitMap& gait_map = make_stance_gait()) const;
 
+  /**
+   * @brief Compose ground reaction forces into a caller-provided map
+   * @param force_map[out] - ground reaction forces in body frame for stance legs
+   * @details Same as the returning overload but writes into the output map.
+   * A steady-state call performs zero heap allocations: all intermediates
+   * are fixed-size stack storage sized by the QP dimensions.
+   */
+  void control(const mat& Rwb, const mat& Rwb_d, const vec& x, const vec& xdot,
+               const vec& w, const vec& x_d, const vec& xdot_d, const vec& w_d,
+               const FootholdMap& foot_map, const GaitMap& gait_map,
+               ForceMap& force_map) const;
+
+  /**
+   * @brief Number of consecutive failed QP solves
+   * @return failed solve count, zero after a successful solve
+   * @details While a cached solution is available control() keeps
+   * returning it on failure; monitor this count to degrade gracefully
+   * when the solver stays infeasible.
+   */
+  unsigned int consecutiveFailures() const;
+
 private:
   /**
    * @brief Compose linear Newton-Euler single rigid body dynamics
@@ -114,13 +142,15 @@ private:
    * @param x - COM position in world [x, y, z] (3x1)
    * @param xddot_d - desired COM linear acceleration (3x1)
    * @param wdot_d - desired COM angular acceleration (3x1)
-   * @return Newton-Euler dynamics written as a linear problem Ax = b [R1] Eq(5)
+   * @param A[out] - Newton-Euler dynamics written as a linear problem Ax = b [R1] Eq(5)
+   * @param b[out] - constant terms in Ax = b
    * @details Euler single rigid body dyanmics are described by tau = I*wdot + w x (I*w).
    * However, the cross product term is small for bodies with small angular velocities
-   * they are included.
+   * they are included. The outputs are fixed-size so no heap is touched.
    */
-  tuple<mat, vec> dynamics(const mat& ft_p, const mat& Rwb, const vec& x,
-                           const vec& xddot_d, const vec& w_d, const vec& wdot_d) const;
+  void dynamics(const mat& ft_p, const mat& Rwb, const vec& x, const vec& xddot_d,
+                const vec& w_d, const vec& wdot_d,
+                mat::fixed<6, 12>& A, vec::fixed<6>& b) const;
 
 private:
   /**
@@ -134,46 +164,50 @@ private:
   /**
    * @brief Set friction code constraint lower and upper bounds
    * @param gait_map - gait schedule
+   * @param lbC[out] - constraint lower bounds
+   * @param ubC[out] - constraint upper bounds
    * @details If a foot is in swing phase the constraint bounds lower = upper = 0,
    * resulting in a zero vector ground reaction force.
    */
-  void frictionConeBounds(const GaitMap& gait_map) const;
+  void frictionConeBounds(const GaitMap& gait_map, vec::fixed<20>& lbC,
+                          vec::fixed<20>& ubC) const;
 
 private:
   // Dynamic properties
   double mu_;    // coefficient of friction (kg*m/s^2)
   double mass_;  // total mass of robot (kg)
-  mat Ib_;       // moment of interia in body frame (kg*m^2) (3x3)
-  vec g_;        // gravity vector in world frame (m/s^2) (3x1)
+  mat33 Ib_;     // moment of interia in body frame (kg*m^2) (3x3)
+  vec3 g_;       // gravity vector in world frame (m/s^2) (3x1)
 
   // PD control gains
-  vec kff_;   // feed forward gains (6x1)
-  vec kp_p_;  // kp gain on COM position (3x1)
-  vec kd_p_;  // kd gain on COM linear velocity (3x1)
-  vec kp_w_;  // kp gain on COM orientaion (3x1)
-  vec kd_w_;  // kd gain on COM angular velocities (3x1)
+  vec::fixed<6> kff_;  // feed forward gains (6x1)
+  vec3 kp_p_;          // kp gain on COM position (3x1)
+  vec3 kd_p_;          // kd gain on COM linear velocity (3x1)
+  vec3 kp_w_;          // kp gain on COM orientaion (3x1)
+  vec3 kd_w_;          // kd gain on COM angular velocities (3x1)
 
   // QP variables
   static const uint64_t num_equations_qp_{ 6 };     // number of equations
   static const uint64_t num_variables_qp_{ 12 };    // number of variable (GRFs)
   static const uint64_t num_constraints_qp_{ 20 };  // total constraints (5 per foot)
 
-  mutable SQProblem QPSolver_;  // sequential QP solver
+  // QP backend selected at build time (see qp_backend.hpp): qpOASES by
+  // default, or the specialized fixed-dimension active-set solver.
+  mutable qp::BalanceQpBackend<num_variables_qp_, num_constraints_qp_> qp_solver_;
 
-  int nWSR_;              // max working set recalculations
   double fzmin_, fzmax_;  // min and max normal reaction force (N)
-  mat S_;                 // positive-definite weight matrix on least sqaures (6x6)
-  mat W_;                 // positive-definite weight matrix on GRFs (12x12)
-  mat C_;                 // friction cone constraint matrix (20x12)
-
-  real_t cpu_time_;  // max CPU time for QP solution (s)
-  // QP standard form 1/2*x.T*Q*x + x.T*c
-  mutable real_t qp_Q_[num_variables_qp_ * num_variables_qp_];
-  mutable real_t qp_c_[num_variables_qp_];
-
-  mutable real_t qp_C_[num_constraints_qp_ * num_variables_qp_];  // constraint matrix
-  mutable real_t qp_lbC_[num_constraints_qp_];  // constraint lower bounds
-  mutable real_t qp_ubC_[num_constraints_qp_];  // constraint upper bounds
+
+  // Weights and constraints are fixed-size so steady-state control()
+  // calls never touch the heap.
+  mat::fixed<6, 6> S_;     // positive-definite weight matrix on least sqaures (6x6)
+  mat::fixed<12, 12> W_;   // positive-definite weight matrix on GRFs (12x12)
+  mat::fixed<20, 12> C_;   // friction cone constraint matrix (20x12)
+
+  // Warm start and fallback cache: the last feasible solution seeds the
+  // next solve and is returned when a solve fails mid-gait.
+  mutable bool solution_cached_{ false };            // a feasible solution is cached
+  mutable unsigned int consecutive_failures_{ 0 };   // failed solves since last success
+  mutable vec::fixed<12> x_prev_;                    // last feasible GRFs (world frame)
 
   // Robot configuration
   std::vector<std::string> leg_names_;
@@ -0,0 +1,138 @@
+/**
+ * @file capture.hpp
+ * @date 2021-11-27
+ * @author Boston Cleek
+ * @brief Memory-mapped input capture for deterministic replay
+ */
+#ifndef CAPTURE_HPP
+#define CAPTURE_HPP
+
+// C++
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <quadruped_controller/types.hpp>
+
+namespace quadruped_controller
+{
+namespace capture
+{
+/** @brief Input stream a record belongs to */
+enum InputType : uint32_t
+{
+  joint_states = 0,  // joint positions and velocities
+  com_state = 1,     // COM pose and velocity twist
+  cmd_vel = 2        // commanded body twist
+};
+
+/**
+ * @brief One captured input, a fixed-size union over the three streams
+ * @details The payload holds the snapshot the commander publishes into
+ * its input state buffers, so replaying the records reproduces exactly
+ * what the control loop read. Layout per type:
+ *  joint_states - q then qdot per leg in [RL FL RR FR] order (24)
+ *  com_state - Rwb column major (9), x (3), xdot (3), w (3)
+ *  cmd_vel - body twist [vx, vy, vz, wx, wy, wz] (6)
+ */
+struct InputRecord
+{
+  uint64_t stamp_ns;  // message time (ns)
+  uint32_t type;      // InputType
+  uint32_t reserved;  // keeps the payload 8 byte aligned
+  double data[24];    // payload, see layout above
+};
+
+/** @brief On-disk file header followed by the record ring */
+struct CaptureFileHeader
+{
+  char magic[8];                  // "QCAPLOG" identifies the schema
+  uint32_t record_size;           // sizeof(InputRecord)
+  uint32_t capacity;              // records in the ring
+  std::atomic<uint64_t> written;  // total records ever written
+};
+
+/** @brief Expected file magic */
+constexpr char CAPTURE_MAGIC[8] = "QCAPLOG";
+
+/** @brief Pack a joint states snapshot */
+InputRecord pack(uint64_t stamp_ns, const JointStatesMap& joint_states_map);
+
+/** @brief Pack a COM state snapshot */
+InputRecord pack(uint64_t stamp_ns, const RobotStateCoM& com_state);
+
+/** @brief Pack a commanded body twist */
+InputRecord pack(uint64_t stamp_ns, const arma::vec::fixed<6>& Vb);
+
+/** @brief Unpack a joint states snapshot, record type must be joint_states */
+JointStatesMap unpackJointStates(const InputRecord& record);
+
+/** @brief Unpack a COM state snapshot, record type must be com_state */
+RobotStateCoM unpackComState(const InputRecord& record);
+
+/** @brief Unpack a commanded body twist, record type must be cmd_vel */
+arma::vec::fixed<6> unpackCmdVel(const InputRecord& record);
+
+/**
+ * @brief Input capture ring backed by a memory-mapped file
+ * @details Same single-writer design as the telemetry logger: the
+ * subscriber callback thread appends one record per message with a
+ * memcpy and a counter store, and a background thread flushes the
+ * mapping to disk at a low rate. The ring survives a crash, so the
+ * inputs leading up to a field failure are recoverable.
+ */
+class InputLogger
+{
+public:
+  /**
+   * @brief Constructor
+   * @param path - capture file path
+   * @param capacity - records in the ring (oldest are overwritten)
+   * @param flush_period - background flush period (s)
+   */
+  InputLogger(const std::string& path, uint32_t capacity, double flush_period);
+
+  /** @brief Destructor, flushes and unmaps the ring */
+  ~InputLogger();
+
+  InputLogger(const InputLogger&) = delete;
+  InputLogger& operator=(const InputLogger&) = delete;
+
+  /** @brief Return true if the file mapped successfully */
+  bool valid() const;
+
+  /**
+   * @brief Append a record to the ring
+   * @param record - captured input
+   */
+  void log(const InputRecord& record);
+
+private:
+  /** @brief Background flush loop */
+  void flushLoop();
+
+private:
+  std::string path_;            // capture file path
+  uint32_t capacity_;           // records in the ring
+  double flush_period_;         // background flush period (s)
+  size_t map_size_;             // total mapping size (bytes)
+  CaptureFileHeader* header_;   // mapped file header
+  InputRecord* records_;        // mapped record ring
+
+  std::atomic_bool flushing_;   // flush thread runs while true
+  std::thread flush_thread_;    // background flush thread
+};
+
+/**
+ * @brief Load a capture file into chronological order
+ * @param path - capture file path
+ * @param records[out] - records oldest first
+ * @return true if the file was read and the schema matches
+ * @details If the ring wrapped only the newest capacity records remain.
+ */
+bool loadCapture(const std::string& path, std::vector<InputRecord>& records);
+}  // namespace capture
+}  // namespace quadruped_controller
+#endif
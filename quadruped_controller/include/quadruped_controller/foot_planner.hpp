@@ -8,6 +8,7 @@
 #define FOOTHOLD_HPP
 
 #include <tuple>
+#include <quadruped_controller/terrain.hpp>
 #include <quadruped_controller/types.hpp>
 
 namespace quadruped_controller
@@ -17,8 +18,21 @@ using std::tuple;
 class FootPlanner
 {
 public:
+  /** @brief Constructor, assumes flat ground at z = 0 */
   FootPlanner();
 
+  /**
+   * @brief Constructor
+   * @param terrain - terrain heightmap candidate footholds snap to
+   */
+  explicit FootPlanner(const TerrainMap& terrain);
+
+  /**
+   * @brief Update the terrain from an external mapping source
+   * @param heights - cell heights (rows x cols) (m)
+   */
+  void updateTerrain(const mat& heights);
+
   tuple<bool, FootholdMap> positions(double t_stance, const mat33& Rwb, const vec3& x,
                                      const vec3& xdot, const vec3& w, const vec3& xdot_d,
                                      const FootholdMap& foot_holds,
@@ -35,8 +49,10 @@ private:
   double g_;  // gravitaional magnitude (m/s^2)
   double k_;  // feedback gain
 
-  std::map<std::string, vec3> hip_map_;  // map leg name to vector from com to hip
-  mutable std::map<std::string, LegState> state_map_;  // map leg name to leg state
+  TerrainMap terrain_;  // heightmap candidate footholds snap to
+
+  LegMap<vec3> hip_map_;                  // map leg to vector from com to hip
+  mutable LegMap<LegState> state_map_;    // map leg to leg state
 };
 }  // namespace quadruped_controller
 #endif
@@ -7,11 +7,9 @@
 #ifndef GAIT_HPP
 #define GAIT_HPP
 
-#include <map>
 #include <string>
-#include <thread>
 #include <atomic>
-#include <mutex>
+#include <cstdint>
 
 #include <quadruped_controller/types.hpp>
 
@@ -20,7 +18,14 @@ namespace quadruped_controller
 /** @brief Compose a pure stance gait with all phases set to zero */
 GaitMap make_stance_gait();
 
-/** @brief Scheduler leg swing and stance phases*/
+/** @brief Scheduler leg swing and stance phases
+ * @details The gait is strictly periodic so the leg phases are a pure
+ * function of the elapsed time and the phase offsets. The schedule is
+ * derived from a monotonic clock on demand: there is no worker thread,
+ * no mutex, and no shared mutable phase state. Elapsed time is tracked
+ * through an atomic epoch timestamp so schedule() is safe to call from
+ * the control loop without ever blocking.
+ */
 class GaitScheduler
 {
 public:
@@ -34,12 +39,12 @@ public:
   GaitScheduler(double t_swing, double t_stance, const vec& offset);
 
   /** @brief Destructor */
-  virtual ~GaitScheduler();
+  virtual ~GaitScheduler() = default;
 
   /** @brief Starts periodic gait */
   void start() const;
 
-  /** @brief Stops periodic gait */
+  /** @brief Stops periodic gait, freezing the phases at their current values */
   void stop() const;
 
   /**
@@ -51,15 +56,30 @@ public:
   /** @brief Get the current gait schedule */
   GaitMap schedule() const;
 
-private:
-  /** @brief Run gait schedule in a separate thread */
-  void execute() const;
+  /**
+   * @brief Contact schedule lookahead over a prediction horizon
+   * @param t_start - time offset from now to the first step (s)
+   * @param dt - time between steps (s)
+   * @param horizon - number of steps, N, in the horizon
+   * @param contacts[out] - contact table (N x 4), 1 = stance and 0 = swing
+   * @param phases[out] - leg phase table (N x 4) on domain [0 1)
+   * @details Legs follow [RL FL RR FR]. The gait is strictly periodic so
+   * the entire table is evaluated in one pass from the closed-form phase
+   * equations rather than stepping a clock. The caller buffers are only
+   * resized when the horizon changes, so repeated queries allocate
+   * nothing. The lookahead assumes the gait keeps running over the
+   * horizon.
+   */
+  void scheduleHorizon(double t_start, double dt, unsigned int horizon,
+                       arma::Mat<unsigned int>& contacts, mat& phases) const;
 
+private:
   /**
-   * @brief Update phases
-   * @param dt - time lapse since last call (s)
+   * @brief Compose elapsed gait time (s)
+   * @details Accumulated run time from previous start/stop cycles plus
+   * the time since the last call to start() when running.
    */
-  void update(double dt) const;
+  double elapsed() const;
 
   /**
    * @brief Compose state of leg
@@ -75,12 +95,11 @@ private:
   double t_stance_;      // stance time (s)
   double stance_phase_;  // stance phase
 
-  vec offset_;          // phase offsets for legs [RL FL RR FR]
-  mutable vec phases_;  // phases for legs [RL FL RR FR]
+  vec offset_;  // phase offsets for legs [RL FL RR FR]
 
-  mutable std::atomic_bool running_;  // true when scheduler started
-  mutable std::thread worker_;        // runs phase updates
-  mutable std::mutex mutex_;          // protect positions_
+  mutable std::atomic_bool running_;         // true when scheduler started
+  mutable std::atomic<int64_t> epoch_ns_;    // monotonic clock time at start() (ns)
+  mutable std::atomic<int64_t> elapsed_ns_;  // run time accumulated before epoch (ns)
 };
 
 }  // namespace quadruped_controller
@@ -0,0 +1,231 @@
+/**
+ * @file instrumentation.hpp
+ * @date 2021-10-16
+ * @author Boston Cleek
+ * @brief Hot path latency instrumentation
+ */
+#ifndef INSTRUMENTATION_HPP
+#define INSTRUMENTATION_HPP
+
+// C++
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <quadruped_msgs/LatencyProfile.h>
+
+namespace quadruped_controller
+{
+namespace instrumentation
+{
+/** @brief Monotonic clock time (ns) */
+uint64_t time_now_ns();
+
+/**
+ * @brief Lock-free latency histogram with logarithmic bins
+ * @details Each sample is a single atomic increment into a power of two
+ * bin plus an atomic max update so recording costs well under a
+ * microsecond. Percentiles are resolved to the upper bound of the bin
+ * they fall in which is accurate to a factor of two - plenty to tell a
+ * blown budget from a healthy stage.
+ */
+class LatencyHistogram
+{
+public:
+  /** @brief Aggregated statistics since the last call to summarize() */
+  struct Summary
+  {
+    uint64_t samples{ 0 };
+    uint64_t p50_ns{ 0 };
+    uint64_t p99_ns{ 0 };
+    uint64_t max_ns{ 0 };
+  };
+
+  /** @brief Constructor */
+  LatencyHistogram();
+
+  /**
+   * @brief Record a duration
+   * @param duration_ns - sample duration (ns)
+   */
+  void record(uint64_t duration_ns);
+
+  /**
+   * @brief Aggregate and reset the histogram
+   * @return sample count, p50, p99, and max
+   */
+  Summary summarize();
+
+private:
+  /**
+   * @brief Compose the bin a duration falls in
+   * @param duration_ns - sample duration (ns)
+   * @return bin index
+   */
+  static unsigned int bin(uint64_t duration_ns);
+
+private:
+  static constexpr unsigned int num_bins_{ 64 };
+  std::array<std::atomic<uint64_t>, num_bins_> bins_;  // sample counts per bin
+  std::atomic<uint64_t> max_ns_;                       // max sample (ns)
+};
+
+/** @brief Records the lifetime of a scope into a histogram */
+class ScopedTimer
+{
+public:
+  /**
+   * @brief Constructor
+   * @param histogram - histogram the duration is recorded into (nullptr disables)
+   * @param last_ns - slot the duration is also stored into (nullptr disables)
+   */
+  explicit ScopedTimer(LatencyHistogram* histogram,
+                       std::atomic<uint64_t>* last_ns = nullptr)
+    : histogram_(histogram)
+    , last_ns_(last_ns)
+    , start_ns_(histogram != nullptr ? time_now_ns() : 0)
+  {
+  }
+
+  /** @brief Destructor */
+  ~ScopedTimer()
+  {
+    if (histogram_ != nullptr)
+    {
+      const auto duration_ns = time_now_ns() - start_ns_;
+      histogram_->record(duration_ns);
+
+      if (last_ns_ != nullptr)
+      {
+        last_ns_->store(duration_ns, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+  LatencyHistogram* histogram_;     // target histogram
+  std::atomic<uint64_t>* last_ns_;  // last duration slot
+  uint64_t start_ns_;               // scope entry time (ns)
+};
+
+/**
+ * @brief Aggregates latency histograms for named pipeline stages
+ * @details Stages are addressed by index so the hot path never hashes a
+ * name. When disabled measure() collapses to calling the stage with no
+ * clock reads.
+ */
+class PipelineProfiler
+{
+public:
+  /**
+   * @brief Constructor
+   * @param stage_names - pipeline stage names in index order
+   * @param enabled - enables sampling
+   */
+  PipelineProfiler(const std::vector<std::string>& stage_names, bool enabled);
+
+  /**
+   * @brief Time one invocation of a pipeline stage
+   * @param stage - stage index
+   * @param callable - stage to invoke
+   * @return the stage's return value
+   */
+  template <typename Callable>
+  auto measure(unsigned int stage, Callable&& callable) const
+  {
+    const ScopedTimer timer(enabled_ ? &histograms_.at(stage) : nullptr,
+                            enabled_ ? &last_ns_.at(stage) : nullptr);
+    return std::forward<Callable>(callable)();
+  }
+
+  /**
+   * @brief Record an externally measured duration for a stage
+   * @param stage - stage index
+   * @param duration_ns - sample duration (ns)
+   */
+  void record(unsigned int stage, uint64_t duration_ns) const;
+
+  /** @brief Zero the per-cycle stage durations, call at the top of a cycle */
+  void resetStageDurations() const;
+
+  /**
+   * @brief Compose the slowest stage measured since resetStageDurations()
+   * @return stage index and its duration (ns)
+   */
+  std::pair<unsigned int, uint64_t> slowestStage() const;
+
+  /** @brief Return true when sampling is enabled */
+  bool enabled() const;
+
+  /**
+   * @brief Aggregate all stages into a message and reset the histograms
+   * @return per stage sample counts, p50, p99, and max
+   */
+  quadruped_msgs::LatencyProfile report() const;
+
+private:
+  bool enabled_;                                  // sampling enabled
+  std::vector<std::string> stage_names_;          // stage names in index order
+  mutable std::vector<LatencyHistogram> histograms_;  // histogram per stage
+  mutable std::vector<std::atomic<uint64_t>> last_ns_;  // last duration per stage (ns)
+};
+
+/**
+ * @brief Deadline watchdog for a fixed-rate control loop
+ * @details Measures every cycle against a budget and keeps overrun
+ * accounting so a blown deadline is visible the cycle it happens rather
+ * than from rate.sleep() silently not sleeping. After degrade_after
+ * consecutive overruns degraded() latches true so the loop can shed
+ * load; it clears again after the same number of in-budget cycles.
+ */
+class DeadlineMonitor
+{
+public:
+  /** @brief One cycle's accounting returned by endCycle() */
+  struct CycleReport
+  {
+    uint64_t duration_ns{ 0 };               // cycle duration (ns)
+    bool overrun{ false };                   // cycle blew the budget
+    bool degraded{ false };                  // degraded mode active
+    bool degraded_changed{ false };          // degraded mode toggled this cycle
+    uint64_t overruns{ 0 };                  // total overruns since construction
+    unsigned int consecutive_overruns{ 0 };  // current overrun streak
+  };
+
+  /**
+   * @brief Constructor
+   * @param budget_ns - cycle budget (ns)
+   * @param degrade_after - consecutive overruns before degraded mode latches
+   */
+  DeadlineMonitor(uint64_t budget_ns, unsigned int degrade_after);
+
+  /** @brief Mark the start of a cycle */
+  void beginCycle();
+
+  /**
+   * @brief Measure the cycle against the budget and update the accounting
+   * @return this cycle's report
+   */
+  CycleReport endCycle();
+
+  /** @brief Return true while degraded mode is latched */
+  bool degraded() const;
+
+private:
+  uint64_t budget_ns_;                        // cycle budget (ns)
+  unsigned int degrade_after_;                // overrun streak that latches degraded mode
+  uint64_t cycle_start_ns_{ 0 };              // beginCycle() timestamp (ns)
+  uint64_t overruns_{ 0 };                    // total overruns
+  unsigned int consecutive_overruns_{ 0 };    // current overrun streak
+  unsigned int consecutive_in_budget_{ 0 };   // current in-budget streak
+  bool degraded_{ false };                    // degraded mode latched
+};
+}  // namespace instrumentation
+}  // namespace quadruped_controller
+#endif
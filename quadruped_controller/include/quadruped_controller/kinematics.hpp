@@ -8,7 +8,7 @@
 #define KINEMATICS_HPP
 
 // C++
-#include <map>
+#include <array>
 #include <string>
 #include <functional>
 #include <cmath>
@@ -87,6 +87,33 @@ public:
    */
   mat33 legJacobianInverse(const std::string& leg_name, const vec3& q) const;
 
+  /**
+   * @brief Batched forward kinematics for all four legs
+   * @param q - joint angles [hip, thigh, calf], one column per leg [RL FL RR FR] (3x4)
+   * @param ft_p[out] - foot positions [x, y, z] relative to base_link per column (3x4)
+   * @details The four legs are identical up to the hip offset and link
+   * signs so the kernel runs on a structure of arrays indexed by LegId.
+   * One pass costs roughly one leg's worth of scalar work and never
+   * touches the heap or a string key.
+   */
+  void forwardKinematicsAll(const mat::fixed<3, 4>& q, mat::fixed<3, 4>& ft_p) const;
+
+  /**
+   * @brief Batched inverse kinematics for all four legs
+   * @param ft_p - foot positions relative to base_link, one column per leg (3x4)
+   * @param q[out] - joint angles [hip, thigh, calf] per column (3x4)
+   */
+  void inverseKinematicsAll(const mat::fixed<3, 4>& ft_p, mat::fixed<3, 4>& q) const;
+
+  /**
+   * @brief Batched geometric jacobians for all four legs
+   * @param q - joint angles [hip, thigh, calf], one column per leg (3x4)
+   * @param jacobians[out] - jacobian per leg indexed by LegId (3x3 each)
+   * @details The trigonometric terms are evaluated once for all legs.
+   */
+  void jacobiansAll(const mat::fixed<3, 4>& q,
+                    std::array<mat33, NUM_LEGS>& jacobians) const;
+
   /**
    * @brief Compose the joint torques for four legs based on the force applied to the foot
    * @param q - joint angles for four legs (12x1)
@@ -106,10 +133,35 @@ public:
   TorqueMap jacobianTransposeControl(const JointStatesMap& joint_states_map,
                                      const ForceMap& force_map) const;
 
+  /**
+   * @brief Batched torque composition for all four legs
+   * @param q - joint angles [hip, thigh, calf], one column per leg [RL FL RR FR] (3x4)
+   * @param f - ground reaction force in body frame, one column per leg (3x4)
+   * @param tau_swing - swing torques [hip, thigh, calf], one column per leg (3x4)
+   * @param stance - true selects J^T f for the leg, false the swing column
+   * @param tau[out] - joint torques for four legs (12x1)
+   * @details Evaluates the four jacobians in one pass and merges the
+   * stance and swing contributions by the contact mask straight into the
+   * caller's buffer - no per-leg map insertions or merges on the hot path.
+   */
+  void jacobianTransposeControl(const mat::fixed<3, 4>& q, const mat::fixed<3, 4>& f,
+                                const mat::fixed<3, 4>& tau_swing,
+                                const std::array<bool, NUM_LEGS>& stance,
+                                vec::fixed<12>& tau) const;
+
 private:
-  // Map leg name to leg link configuration and translation from base to hip
-  std::map<std::string, std::pair<vec3, vec3>> link_map_;
+  // Map leg to leg link configuration and translation from base to hip
+  LegMap<std::pair<vec3, vec3>> link_map_;
   vec3 links_;  // lengths [l1 l2 l3]
+
+  // SoA per-leg constants for the batched kernels (index = LegId)
+  std::array<double, NUM_LEGS> hip_x_;   // base to hip translation x
+  std::array<double, NUM_LEGS> hip_y_;   // base to hip translation y
+  std::array<double, NUM_LEGS> hip_z_;   // base to hip translation z
+  std::array<double, NUM_LEGS> l1_;      // signed hip link length
+  std::array<bool, NUM_LEGS> right_leg_; // true for RR and FR
+  double l2_;                            // signed thigh link length
+  double l3_;                            // signed calf link length
 };
 }  // namespace quadruped_controller
 #endif
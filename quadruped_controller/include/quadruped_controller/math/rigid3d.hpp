@@ -11,11 +11,6 @@
 #include <iosfwd>
 #include <tuple>
 
-// Drake
-#include <drake/math/rotation_matrix.h>
-#include <drake/math/rigid_transform.h>
-#include <drake/math/roll_pitch_yaw.h>
-
 // Linear Algebra
 #include <armadillo>
 
@@ -26,26 +21,17 @@ namespace math
 using std::tuple;
 
 using arma::mat;
+using arma::mat33;
+using arma::mat44;
 using arma::vec;
 using arma::vec3;
 
-/** @brief Copy Eigen matrix to Armadillo matrix */
-mat eigen_to_arma(const Eigen::MatrixXd& R_eigen);
-
-// vec eigen_to_arma(const Eigen::VectorXd& p_eigen);
-
-/** @brief Copy Armadillo rotation matrix (3x3) to Eigen matrix */
-Eigen::Matrix3d arma_rotation_to_eigen(const mat& R_arma);
-
-/** @brief Copy Armadillo translation vecotr to Eigen vector */
-Eigen::Vector3d arma_translation_to_eigen(const vec3& p);
-
 /**
  * @brief Compose a skew symmetric matrix
  * @param x - vector
  * @return skew symmetric matrix
  */
-mat skew_symmetric(const vec3& x);
+mat33 skew_symmetric(const vec3& x);
 
 /** @brief Rotation in three-dimensional catesian space */
 class Rotation3d;
@@ -60,12 +46,6 @@ public:
   /** @brief Constructor q = qw + qx*i + qy*j + qz*k */
   Quaternion(double qw, double qx, double qy, double qz);
 
-  /**
-   * @brief Constructor
-   * @param q - Eigen quaternion
-   */
-  Quaternion(const Eigen::Quaterniond& q);
-
   /**
    * @brief Constructor
    * @param R - three-dimensional rotation
@@ -89,7 +69,7 @@ public:
   Rotation3d rotation() const;
 
   /** @brief Return rotation matrix (3x3) */
-  mat matrix() const;
+  mat33 matrix() const;
 
   /** @brief Return roll, pitch, and yaw angles (radians) */
   vec3 eulerAngles() const;
@@ -100,9 +80,6 @@ public:
   /** @brief Return true if ||q|| = 1 */
   bool isUnit() const;
 
-  /** @brief Return Eigen quaternion<double> */
-  const Eigen::Quaterniond& data() const;
-
   /** @brief Return qw */
   double w() const;
 
@@ -116,7 +93,7 @@ public:
   double z() const;
 
 private:
-  Eigen::Quaterniond q_;
+  double qw_, qx_, qy_, qz_;
 };
 
 class Rotation3d
@@ -165,22 +142,16 @@ public:
   vec angleAxisTotal() const;
 
   /** @brief Return rotation matrix (3x3) */
-  mat matrix() const;
-
-  /** @brief Return drake rotation matrix */
-  const drake::math::RotationMatrix<double>& data() const;
+  const mat33& matrix() const;
 
   /** @brief Return rotation as a quaternion */
   Quaternion toQuaternion() const;
 
-  /** @brief Return rotation as a Eigen quaternion */
-  Eigen::Quaterniond toEigenQuaternion() const;
-
   /** @brief Print contents to stdout */
   void print(const std::string& msg = "") const;
 
 private:
-  drake::math::RotationMatrix<double> R_;
+  mat33 R_;
 };
 
 /** @brief Three-dimensional transformation */
@@ -196,12 +167,6 @@ public:
    */
   Transform3d(const vec3& p);
 
-  /**
-   * @brief Constructor
-   * @param T - drake transformation
-   */
-  Transform3d(const drake::math::RigidTransform<double>& T);
-
   /**
    * @brief Constructor
    * @param q - quaternion
@@ -228,7 +193,7 @@ public:
    * @details Assumes the velocity twist is a six-dimensional
    * vector of the form [vy, vy, vz, wx, wy, wz]
    */
-  mat adjoint() const;
+  mat::fixed<6, 6> adjoint() const;
 
   /** @brief Return rotation and translation components */
   tuple<Quaternion, vec3> components() const;
@@ -253,20 +218,18 @@ public:
    */
   vec3 operator*(const vec3& p) const;
 
-  /** @brief Return drake transformation representation */
-  const drake::math::RigidTransform<double>& data() const;
-
   /** @brief Return inverse homogenous transformation matrix (4x4) */
-  mat inverse() const;
+  mat44 inverse() const;
 
   /** @brief Return homogenous transformation matrix (4x4) */
-  mat matrix() const;
+  mat44 matrix() const;
 
   /** @brief Print contents to stdout */
   void print(const std::string& msg = "") const;
 
 private:
-  drake::math::RigidTransform<double> T_;
+  mat33 R_;  // rotation component (3x3)
+  vec3 p_;   // translation component [x, y, z]
 };
 
 /** @brief Robot pose */
@@ -0,0 +1,159 @@
+/**
+ * @file mpc_controller.hpp
+ * @date 2021-09-18
+ * @author Boston Cleek
+ * @brief Convex model predictive controller
+ */
+#ifndef MPC_CONTROLLER_HPP
+#define MPC_CONTROLLER_HPP
+
+// C++
+#include <vector>
+
+// QP solver
+#include <qpOASES.hpp>
+
+#include <quadruped_controller/math/rigid3d.hpp>
+#include <quadruped_controller/gait.hpp>
+
+namespace quadruped_controller
+{
+using arma::eye;
+using arma::mat;
+using arma::vec;
+
+using math::Quaternion;
+using math::skew_symmetric;
+
+using qpOASES::real_t;
+using qpOASES::returnValue;
+using qpOASES::SQProblem;
+
+/** @brief Receding horizon optimal control strategy
+ * @details The single rigid body dynamics used by the balance controller
+ * are propagated over an N-step prediction horizon and the ground reaction
+ * forces for the entire horizon are optimized in a single condensed QP.
+ * The condensed QP is block-banded: the prediction matrix is lower block
+ * triangular and the friction cone constraints are block diagonal, so only
+ * the non-zero blocks are formed when condensing.
+ */
+class ConvexMPC
+{
+public:
+  /**
+   * @brief Constructor
+   * @param mu - friction coefficient (kg*m/s^2)
+   * @param mass - total mass (kg)
+   * @param fzmin - minimum z-axis ground reaction force (N)
+   * @param fzmax - maximum z-axis ground reaction force (N)
+   * @param Ib - trunk moment of inertia (kg*m^2)
+   * @param Q - positive-definite weights on the state reference error (12x1)
+   * @param R - positive weight on the GRFs
+   * @param horizon - number of steps, N, in the prediction horizon
+   * @param dt - prediction time step (s)
+   * @param leg_names - vector of legs names
+   */
+  ConvexMPC(double mu, double mass, double fzmin, double fzmax, const mat& Ib,
+            const vec& Q, double R, unsigned int horizon, double dt,
+            const std::vector<std::string>& leg_names);
+
+  /**
+   * @brief Compose ground reaction forces for the first step in the horizon
+   * @param Rwb - rotation from world to base_link (3x3)
+   * @param Rwb_d - desired rotation from world to base_link (3x3)
+   * @param x - COM position in world [x, y, z] (3x1)
+   * @param xdot - COM linear velocity in world [vx, vy, vz] (3x1)
+   * @param w - COM angular velocity in world [wx, wy, wz] (3x1)
+   * @param x_d - desired COM position in world [x, y, z] (3x1)
+   * @param xdot_d - desired COM linear velocity in world [vx, vy, vz] (3x1)
+   * @param w_d - desired COM angular velocity in world [wx, wy, wz] (3x1)
+   * @param foot_map - postions of feet in body frame
+   * @param gait_map - gait schedule
+   * @param contact_horizon - predicted contact table (N x 4), 1 = stance
+   * @return ground reaction forces in body frame for the stance legs
+   * @details The desired velocities are integrated forward to construct the
+   * reference trajectory over the horizon. Only the forces for the first
+   * step are returned, the remainder of the horizon is discarded and the
+   * QP is re-solved on the next tick (receding horizon). When a contact
+   * table from GaitScheduler::scheduleHorizon is provided the friction
+   * cone bounds follow the predicted contact sequence, otherwise the
+   * current gait schedule is held constant over the horizon.
+   */
+  ForceMap control(const mat& Rwb, const mat& Rwb_d, const vec& x, const vec& xdot,
+                   const vec& w, const vec& x_d, const vec& xdot_d, const vec& w_d,
+                   const FootholdMap& foot_map,
+                   const GaitMap& gait_map = make_stance_gait(),
+                   const arma::Mat<unsigned int>& contact_horizon =
+                       arma::Mat<unsigned int>()) const;
+
+private:
+  /**
+   * @brief Compose discrete time single rigid body dynamics
+   * @param ft_p - postions of feet in body frame (3x4)
+   * @param Rwb - rotation from world to base_link (3x3)
+   * @param yaw - current yaw angle (rad)
+   * @param A[out] - discrete state transition matrix (13x13)
+   * @param B[out] - discrete control matrix (13x12)
+   * @details The state is [theta, p, w, pdot, g] where theta are the
+   * ZYX euler angles. The dynamics are the same linear Newton-Euler
+   * equations used by the balance controller [R2] Eq(16) and Eq(17)
+   * linearized about the current yaw angle and discretized with a
+   * first order hold.
+   */
+  void dynamics(const mat& ft_p, const mat& Rwb, double yaw, mat& A, mat& B) const;
+
+  /**
+   * @brief Construct friction cone contraint for one leg
+   * @return friction cone constraint matrix (5x3)
+   * @details Same cone structure used by the balance controller.
+   */
+  mat frictionConeConstraint() const;
+
+  /**
+   * @brief Set friction cone constraint lower and upper bounds over the horizon
+   * @param gait_map - gait schedule
+   * @param contact_horizon - predicted contact table (N x 4), 1 = stance
+   * @details If a foot is in swing phase the constraint bounds lower = upper = 0,
+   * resulting in a zero vector ground reaction force for that step. Steps
+   * covered by the contact table use the predicted contact states, the
+   * remainder fall back to the current gait schedule.
+   */
+  void frictionConeBounds(const GaitMap& gait_map,
+                          const arma::Mat<unsigned int>& contact_horizon) const;
+
+private:
+  // Dynamic properties
+  double mu_;    // coefficient of friction (kg*m/s^2)
+  double mass_;  // total mass of robot (kg)
+  mat Ib_;       // moment of interia in body frame (kg*m^2) (3x3)
+
+  // MPC dimensions
+  static const uint64_t num_states_{ 13 };      // states per step
+  static const uint64_t num_controls_{ 12 };    // GRFs per step
+  static const uint64_t num_constraints_{ 20 };  // constraints per step (5 per foot)
+
+  unsigned int horizon_;  // prediction steps N
+  double dt_;             // prediction time step (s)
+
+  mat Q_;    // state error weights over horizon (13N x 13N)
+  mat R_;    // GRF weights over horizon (12N x 12N)
+  mat Cf_;   // friction cone for one leg (5x3)
+
+  mutable SQProblem QPSolver_;  // sequential QP solver
+
+  int nWSR_;              // max working set recalculations
+  double fzmin_, fzmax_;  // min and max normal reaction force (N)
+
+  real_t cpu_time_;  // max CPU time for QP solution (s)
+  // QP standard form 1/2*U.T*H*U + U.T*g
+  mutable std::vector<real_t> qp_H_;    // hessian (12N x 12N)
+  mutable std::vector<real_t> qp_g_;    // gradient (12N x 1)
+  mutable std::vector<real_t> qp_C_;    // constraint matrix (20N x 12N)
+  mutable std::vector<real_t> qp_lbC_;  // constraint lower bounds (20N x 1)
+  mutable std::vector<real_t> qp_ubC_;  // constraint upper bounds (20N x 1)
+
+  // Robot configuration
+  std::vector<std::string> leg_names_;
+};
+}  // namespace quadruped_controller
+#endif
@@ -0,0 +1,505 @@
+/**
+ * @file qp_backend.hpp
+ * @date 2021-12-04
+ * @author Boston Cleek
+ * @brief Fixed-dimension QP solver backends for the balance controller
+ */
+#ifndef QP_BACKEND_HPP
+#define QP_BACKEND_HPP
+
+// C++
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// QP solver
+#include <qpOASES.hpp>
+
+// Linear Algebra
+#include <armadillo>
+
+namespace quadruped_controller
+{
+namespace qp
+{
+using arma::mat;
+using arma::vec;
+
+// The qpOASES handoff below is bulk memcpy from armadillo storage
+static_assert(std::is_same_v<qpOASES::real_t, double>,
+              "zero-copy qpOASES handoff requires double precision real_t");
+
+/**
+ * @brief qpOASES sequential QP backend
+ * @tparam NumVars - number of optimization variables
+ * @tparam NumCons - number of constraints
+ * @details Wraps a dense SQProblem sized by the constexpr dimensions.
+ * The first solve runs a cold init (seeded with the warm-start point
+ * when one is available) and subsequent solves hotstart from the
+ * previous working set. A failed solve resets the solver so the next
+ * tick rebuilds the working set from scratch.
+ */
+template <uint64_t NumVars, uint64_t NumCons>
+class QpOasesBackend
+{
+public:
+  /** @brief Constructor */
+  QpOasesBackend() : solver_(NumVars, NumCons), nWSR_(200), cpu_time_(0.01)
+  {
+    // Disable printing
+    solver_.setPrintLevel(qpOASES::PL_NONE);
+  }
+
+  /**
+   * @brief Cache a constant constraint matrix
+   * @param C - constraint matrix
+   * @details The row-major conversion happens once here and solve()
+   * skips it on every tick, so a constant constraint matrix is never
+   * re-copied on the hot path.
+   */
+  void setConstraintMatrix(const mat::fixed<NumCons, NumVars>& C)
+  {
+    copyRowMajor(C, qp_C_);
+    constraints_cached_ = true;
+  }
+
+  /**
+   * @brief Solve min 1/2 x^T Q x + c^T x subject to lbC <= C x <= ubC
+   * @param Q - positive-definite cost matrix
+   * @param c - cost vector
+   * @param C - constraint matrix
+   * @param lbC - constraint lower bounds
+   * @param ubC - constraint upper bounds
+   * @param x0 - warm-start point, used to seed the initial solve
+   * @param warm - true when x0 holds a previous feasible solution
+   * @param x[out] - primal solution, valid only when true is returned
+   * @return true on a successful solve
+   */
+  bool solve(const mat::fixed<NumVars, NumVars>& Q, const vec::fixed<NumVars>& c,
+             const mat::fixed<NumCons, NumVars>& C, const vec::fixed<NumCons>& lbC,
+             const vec::fixed<NumCons>& ubC, const vec::fixed<NumVars>& x0, bool warm,
+             vec::fixed<NumVars>& x)
+  {
+    // Q is symmetric so its row-major and column-major layouts
+    // coincide and the handoff is a single bulk copy
+    std::memcpy(qp_Q_, Q.memptr(), sizeof(qp_Q_));
+
+    if (!constraints_cached_)
+    {
+      copyRowMajor(C, qp_C_);
+    }
+
+    std::memcpy(qp_c_, c.memptr(), sizeof(qp_c_));
+    std::memcpy(qp_x0_, x0.memptr(), sizeof(qp_x0_));
+    std::memcpy(qp_lbC_, lbC.memptr(), sizeof(qp_lbC_));
+    std::memcpy(qp_ubC_, ubC.memptr(), sizeof(qp_ubC_));
+
+    // No lower/upper bound constraints on the variables because
+    // the constraint matrix takes care of this.
+    qpOASES::real_t* qp_lb = nullptr;
+    qpOASES::real_t* qp_ub = nullptr;
+
+    // Will update based on actual
+    int nWSR_actual = nWSR_;
+    qpOASES::real_t cpu_time_actual = cpu_time_;
+
+    auto solved = false;
+    if (!solver_.isInitialised())
+    {
+      const qpOASES::returnValue ret_val =
+          warm ? solver_.init(qp_Q_, qp_c_, qp_C_, qp_lb, qp_ub, qp_lbC_, qp_ubC_,
+                              nWSR_actual, &cpu_time_actual, qp_x0_) :
+                 solver_.init(qp_Q_, qp_c_, qp_C_, qp_lb, qp_ub, qp_lbC_, qp_ubC_,
+                              nWSR_actual, &cpu_time_actual);
+
+      solved = (ret_val == qpOASES::SUCCESSFUL_RETURN);
+    }
+    else
+    {
+      const qpOASES::returnValue ret_val =
+          solver_.hotstart(qp_Q_, qp_c_, qp_C_, qp_lb, qp_ub, qp_lbC_, qp_ubC_,
+                           nWSR_actual, &cpu_time_actual);
+
+      solved = (ret_val == qpOASES::SUCCESSFUL_RETURN);
+    }
+
+    if (!solved || !solver_.isSolved())
+    {
+      // Rebuild the working set on the next tick
+      solver_.reset();
+      return false;
+    }
+
+    solver_.getPrimalSolution(qp_xOpt_);
+    for (uint64_t i = 0; i < NumVars; i++)
+    {
+      x(i) = qp_xOpt_[i];
+    }
+
+    return true;
+  }
+
+private:
+  /** @brief Copy a column-major matrix into a row-major array */
+  template <uint64_t Rows, uint64_t Cols>
+  static void copyRowMajor(const mat::fixed<Rows, Cols>& source, qpOASES::real_t* target)
+  {
+    // The transpose is column-major contiguous in row-major order, so
+    // the conversion is one vectorized transpose plus a bulk copy
+    const mat::fixed<Cols, Rows> transposed = source.t();
+    std::memcpy(target, transposed.memptr(), Rows * Cols * sizeof(qpOASES::real_t));
+  }
+
+private:
+  qpOASES::SQProblem solver_;       // sequential QP solver
+  int nWSR_;                        // max working set recalculations
+  qpOASES::real_t cpu_time_;        // max CPU time for QP solution (s)
+  bool constraints_cached_{ false };  // qp_C_ holds a constant constraint matrix
+
+  qpOASES::real_t qp_Q_[NumVars * NumVars];  // cost matrix (row major)
+  qpOASES::real_t qp_c_[NumVars];            // cost vector
+  qpOASES::real_t qp_C_[NumCons * NumVars];  // constraint matrix (row major)
+  qpOASES::real_t qp_lbC_[NumCons];          // constraint lower bounds
+  qpOASES::real_t qp_ubC_[NumCons];          // constraint upper bounds
+  qpOASES::real_t qp_x0_[NumVars];           // warm-start point
+  qpOASES::real_t qp_xOpt_[NumVars];         // primal solution
+};
+
+/**
+ * @brief Specialized primal active-set backend with fixed dimensions
+ * @tparam NumVars - number of optimization variables
+ * @tparam NumCons - number of constraints
+ * @details Solves the same dense QP as the qpOASES backend but with
+ * everything sized at compile time: the KKT system is a fixed
+ * (NumVars + NumCons)^2 matrix solved by an in-place elimination on
+ * stack storage, so a solve never allocates. The working set and the
+ * last feasible point persist across calls - at a control rate the
+ * active set rarely changes between ticks, so the warm-started solve
+ * typically converges in a couple of iterations. Constraint rows with
+ * equal bounds (swing legs) are held as equalities; redundant equality
+ * rows are handled with a small dual regularization.
+ */
+template <uint64_t NumVars, uint64_t NumCons>
+class ActiveSetBackend
+{
+public:
+  /** @brief Constructor */
+  ActiveSetBackend() : warm_valid_(false)
+  {
+    active_.fill(0);
+  }
+
+  /**
+   * @brief Cache a constant constraint matrix
+   * @details No-op: this backend works on the armadillo storage passed
+   * to solve() directly and never copies the constraint matrix.
+   */
+  void setConstraintMatrix(const mat::fixed<NumCons, NumVars>&)
+  {
+  }
+
+  /**
+   * @brief Solve min 1/2 x^T Q x + c^T x subject to lbC <= C x <= ubC
+   * @param Q - positive-definite cost matrix
+   * @param c - cost vector
+   * @param C - constraint matrix
+   * @param lbC - constraint lower bounds
+   * @param ubC - constraint upper bounds
+   * @param x0 - feasible fallback starting point
+   * @param warm - unused, the backend keeps its own warm-start state
+   * @param x[out] - primal solution, valid only when true is returned
+   * @return true on a successful solve
+   */
+  bool solve(const mat::fixed<NumVars, NumVars>& Q, const vec::fixed<NumVars>& c,
+             const mat::fixed<NumCons, NumVars>& C, const vec::fixed<NumCons>& lbC,
+             const vec::fixed<NumCons>& ubC, const vec::fixed<NumVars>& x0, bool warm,
+             vec::fixed<NumVars>& x)
+  {
+    (void)warm;
+
+    // Start from the previous solution when it remains feasible under
+    // the new bounds, otherwise from the caller's fallback point
+    if (warm_valid_ && feasible(C, lbC, ubC, x_prev_))
+    {
+      x = x_prev_;
+      pruneWorkingSet(C, lbC, ubC, x);
+    }
+    else
+    {
+      if (!feasible(C, lbC, ubC, x0))
+      {
+        return false;
+      }
+
+      x = x0;
+      resetWorkingSet(lbC, ubC);
+    }
+
+    for (unsigned int iteration = 0; iteration < max_iterations_; iteration++)
+    {
+      // KKT system over [d, mu]: stationarity rows plus one row per
+      // constraint - active rows pin C_i d = 0, inactive rows pin
+      // mu_i = 0. Redundant active rows get a small dual regularization.
+      kkt_.zeros();
+      rhs_.zeros();
+
+      kkt_.submat(0, 0, NumVars - 1, NumVars - 1) = Q;
+      kkt_.submat(0, NumVars, NumVars - 1, NumVars + NumCons - 1) = C.t();
+      rhs_.rows(0, NumVars - 1) = -(Q * x + c);
+
+      for (uint64_t i = 0; i < NumCons; i++)
+      {
+        if (active_.at(i) != 0)
+        {
+          kkt_.submat(NumVars + i, 0, NumVars + i, NumVars - 1) = C.row(i);
+          kkt_(NumVars + i, NumVars + i) = -dual_regularization_;
+        }
+        else
+        {
+          kkt_(NumVars + i, NumVars + i) = 1.0;
+        }
+      }
+
+      if (!solveInPlace())
+      {
+        return false;
+      }
+
+      const auto step_norm = arma::norm(rhs_.rows(0, NumVars - 1), "inf");
+      if (step_norm < step_tol_)
+      {
+        // Stationary on the working set: optimal unless a multiplier
+        // has the wrong sign (upper bounds need mu >= 0, lower mu <= 0)
+        auto worst = -1;
+        auto worst_violation = multiplier_tol_;
+
+        for (uint64_t i = 0; i < NumCons; i++)
+        {
+          // Equality rows stay in the working set
+          if (active_.at(i) == 0 || (ubC(i) - lbC(i)) < bound_tol_)
+          {
+            continue;
+          }
+
+          const auto mu = rhs_(NumVars + i);
+          const auto violation = (active_.at(i) > 0) ? -mu : mu;
+
+          if (violation > worst_violation)
+          {
+            worst_violation = violation;
+            worst = static_cast<int>(i);
+          }
+        }
+
+        if (worst < 0)
+        {
+          x_prev_ = x;
+          warm_valid_ = true;
+          return true;
+        }
+
+        active_.at(worst) = 0;
+        continue;
+      }
+
+      // Step to the nearest blocking constraint
+      auto alpha = 1.0;
+      auto blocker = -1;
+      auto blocker_bound = 0;
+
+      for (uint64_t i = 0; i < NumCons; i++)
+      {
+        if (active_.at(i) != 0)
+        {
+          continue;
+        }
+
+        const auto cd = arma::dot(C.row(i), rhs_.rows(0, NumVars - 1));
+        const auto cx = arma::dot(C.row(i), x);
+
+        if (cd > step_tol_)
+        {
+          const auto alpha_i = (ubC(i) - cx) / cd;
+          if (alpha_i < alpha)
+          {
+            alpha = alpha_i;
+            blocker = static_cast<int>(i);
+            blocker_bound = 1;
+          }
+        }
+        else if (cd < -step_tol_)
+        {
+          const auto alpha_i = (lbC(i) - cx) / cd;
+          if (alpha_i < alpha)
+          {
+            alpha = alpha_i;
+            blocker = static_cast<int>(i);
+            blocker_bound = -1;
+          }
+        }
+      }
+
+      if (alpha < 0.0)
+      {
+        alpha = 0.0;
+      }
+
+      x += alpha * rhs_.rows(0, NumVars - 1);
+
+      if (blocker >= 0)
+      {
+        active_.at(blocker) = blocker_bound;
+      }
+    }
+
+    return false;
+  }
+
+private:
+  /** @brief Return true when x satisfies every constraint within tolerance */
+  static bool feasible(const mat::fixed<NumCons, NumVars>& C,
+                       const vec::fixed<NumCons>& lbC, const vec::fixed<NumCons>& ubC,
+                       const vec::fixed<NumVars>& x)
+  {
+    for (uint64_t i = 0; i < NumCons; i++)
+    {
+      const auto cx = arma::dot(C.row(i), x);
+      if (cx < lbC(i) - feasibility_tol_ || cx > ubC(i) + feasibility_tol_)
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  /** @brief Keep only the working set entries still tight at x */
+  void pruneWorkingSet(const mat::fixed<NumCons, NumVars>& C,
+                       const vec::fixed<NumCons>& lbC, const vec::fixed<NumCons>& ubC,
+                       const vec::fixed<NumVars>& x)
+  {
+    for (uint64_t i = 0; i < NumCons; i++)
+    {
+      if ((ubC(i) - lbC(i)) < bound_tol_)
+      {
+        active_.at(i) = 1;
+        continue;
+      }
+
+      if (active_.at(i) == 0)
+      {
+        continue;
+      }
+
+      const auto cx = arma::dot(C.row(i), x);
+      const auto bound = (active_.at(i) > 0) ? ubC(i) : lbC(i);
+
+      if (std::abs(cx - bound) > feasibility_tol_)
+      {
+        active_.at(i) = 0;
+      }
+    }
+  }
+
+  /** @brief Activate only the equality rows (equal bounds) */
+  void resetWorkingSet(const vec::fixed<NumCons>& lbC, const vec::fixed<NumCons>& ubC)
+  {
+    for (uint64_t i = 0; i < NumCons; i++)
+    {
+      active_.at(i) = ((ubC(i) - lbC(i)) < bound_tol_) ? 1 : 0;
+    }
+  }
+
+  /**
+   * @brief Solve kkt_ * z = rhs_ in place, the solution lands in rhs_
+   * @return false when a pivot vanishes
+   * @details Gaussian elimination with partial pivoting on the fixed
+   * stack storage - no LAPACK workspace or heap.
+   */
+  bool solveInPlace()
+  {
+    constexpr uint64_t n = NumVars + NumCons;
+
+    for (uint64_t k = 0; k < n; k++)
+    {
+      // Partial pivot
+      auto pivot_row = k;
+      auto pivot_mag = std::abs(kkt_(k, k));
+
+      for (uint64_t i = k + 1; i < n; i++)
+      {
+        const auto mag = std::abs(kkt_(i, k));
+        if (mag > pivot_mag)
+        {
+          pivot_mag = mag;
+          pivot_row = i;
+        }
+      }
+
+      if (pivot_mag < pivot_tol_)
+      {
+        return false;
+      }
+
+      if (pivot_row != k)
+      {
+        kkt_.swap_rows(k, pivot_row);
+        rhs_.swap_rows(k, pivot_row);
+      }
+
+      for (uint64_t i = k + 1; i < n; i++)
+      {
+        const auto factor = kkt_(i, k) / kkt_(k, k);
+        if (factor != 0.0)
+        {
+          kkt_.row(i).cols(k, n - 1) -= factor * kkt_.row(k).cols(k, n - 1);
+          rhs_(i) -= factor * rhs_(k);
+        }
+      }
+    }
+
+    // Back substitution
+    for (auto i = static_cast<int64_t>(n) - 1; i >= 0; i--)
+    {
+      auto sum = rhs_(i);
+      for (auto j = static_cast<uint64_t>(i) + 1; j < n; j++)
+      {
+        sum -= kkt_(i, j) * rhs_(j);
+      }
+
+      rhs_(i) = sum / kkt_(i, i);
+    }
+
+    return true;
+  }
+
+private:
+  static constexpr unsigned int max_iterations_{ 100 };    // active-set iterations
+  static constexpr double step_tol_{ 1.0e-9 };             // zero step threshold
+  static constexpr double multiplier_tol_{ 1.0e-9 };       // multiplier sign tolerance
+  static constexpr double feasibility_tol_{ 1.0e-7 };      // constraint tolerance
+  static constexpr double bound_tol_{ 1.0e-12 };           // equal bound detection
+  static constexpr double pivot_tol_{ 1.0e-12 };           // singular pivot threshold
+  static constexpr double dual_regularization_{ 1.0e-9 };  // redundant row handling
+
+  std::array<int, NumCons> active_;  // working set: 0 inactive, +1 upper, -1 lower
+  bool warm_valid_;                  // x_prev_ holds a feasible solution
+  vec::fixed<NumVars> x_prev_;       // previous primal solution
+
+  mat::fixed<NumVars + NumCons, NumVars + NumCons> kkt_;  // KKT system
+  vec::fixed<NumVars + NumCons> rhs_;                     // right hand side / solution
+};
+
+/** @brief Balance QP backend selected at build time (see BALANCE_QP_BACKEND) */
+#ifdef QUADRUPED_QP_ACTIVE_SET
+template <uint64_t NumVars, uint64_t NumCons>
+using BalanceQpBackend = ActiveSetBackend<NumVars, NumCons>;
+#else
+template <uint64_t NumVars, uint64_t NumCons>
+using BalanceQpBackend = QpOasesBackend<NumVars, NumCons>;
+#endif
+}  // namespace qp
+}  // namespace quadruped_controller
+#endif
@@ -0,0 +1,178 @@
+/**
+ * @file realtime.hpp
+ * @date 2021-09-25
+ * @author Boston Cleek
+ * @brief Real-time executor utilities: lock-free state snapshots and
+ * thread scheduling configuration
+ */
+#ifndef REALTIME_HPP
+#define REALTIME_HPP
+
+// C++
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace quadruped_controller
+{
+namespace realtime
+{
+/**
+ * @brief Single-writer lock-free snapshot buffer (seqlock)
+ * @tparam T - snapshot type, must be copyable without touching shared state
+ * @details One thread publishes snapshots with write() and any number of
+ * threads retrieve the latest consistent snapshot with read(). Readers
+ * never block the writer: a reader that observes a torn copy simply
+ * retries. Intended for small fixed-size state structs crossing from
+ * subscriber callbacks into the control thread.
+ */
+template <typename T>
+class StateBuffer
+{
+public:
+  /** @brief Constructor, the initial snapshot is default constructed */
+  StateBuffer() : sequence_(0)
+  {
+  }
+
+  /**
+   * @brief Constructor
+   * @param value - initial snapshot
+   */
+  explicit StateBuffer(const T& value) : data_(value), sequence_(0)
+  {
+  }
+
+  /**
+   * @brief Publish a new snapshot
+   * @param value - snapshot contents
+   * @details Must only be called from a single writer thread.
+   */
+  void write(const T& value)
+  {
+    // Odd sequence marks the write in progress
+    const auto seq = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(seq + 1, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    data_ = value;
+
+    std::atomic_thread_fence(std::memory_order_release);
+    sequence_.store(seq + 2, std::memory_order_release);
+  }
+
+  /**
+   * @brief Retrieve the latest consistent snapshot
+   * @return copy of the most recent snapshot
+   * @details Lock-free: retries if the writer published mid-copy.
+   */
+  T read() const
+  {
+    T value;
+    uint64_t seq_before = 0;
+    uint64_t seq_after = 0;
+
+    do
+    {
+      seq_before = sequence_.load(std::memory_order_acquire);
+      if (seq_before & 1u)
+      {
+        continue;  // write in progress
+      }
+
+      value = data_;
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      seq_after = sequence_.load(std::memory_order_acquire);
+    } while (seq_before != seq_after);
+
+    return value;
+  }
+
+private:
+  T data_;                              // latest snapshot
+  std::atomic<uint64_t> sequence_;      // even when stable, odd mid-write
+};
+
+/**
+ * @brief Fork-join task pool with spinning workers
+ * @details Persistent worker threads spin on a generation counter with
+ * backoff, so handing a batch of microsecond-scale tasks to the pool
+ * costs a few atomic operations instead of a mutex and condition
+ * variable wake. run() fans task indices across the workers and the
+ * calling thread, which participates in the batch and then spins until
+ * it completes (fork-join). Tasks in one batch must be independent and
+ * run() must only be called from one thread.
+ */
+class TaskPool
+{
+public:
+  /** @brief Task entry point: shared context and task index */
+  using TaskFn = void (*)(void* context, unsigned int index);
+
+  /**
+   * @brief Constructor
+   * @param num_threads - worker threads to start (the caller also works)
+   */
+  explicit TaskPool(unsigned int num_threads);
+
+  /** @brief Destructor, stops and joins the workers */
+  ~TaskPool();
+
+  TaskPool(const TaskPool&) = delete;
+  TaskPool& operator=(const TaskPool&) = delete;
+
+  /**
+   * @brief Execute a batch of tasks and wait for all of them
+   * @param fn - task entry point
+   * @param context - shared context handed to every task
+   * @param num_tasks - task indices [0 num_tasks) are claimed atomically
+   * @details No allocations and no per-task wakeups: the batch is
+   * published with one release store and claimed by atomic increments.
+   */
+  void run(TaskFn fn, void* context, unsigned int num_tasks);
+
+private:
+  /** @brief Worker loop: spin for the next batch then help drain it */
+  void workerLoop();
+
+  /** @brief Claim and execute task indices until the batch is drained */
+  void drainBatch();
+
+private:
+  std::atomic<bool> running_{ true };          // workers keep spinning
+  std::atomic<uint64_t> generation_{ 0 };      // batch generation counter
+  std::atomic<unsigned int> next_task_{ 0 };   // next unclaimed task index
+  std::atomic<unsigned int> completed_{ 0 };   // finished tasks in the batch
+
+  TaskFn fn_{ nullptr };         // current batch entry point
+  void* context_{ nullptr };     // current batch context
+  unsigned int num_tasks_{ 0 };  // tasks in the current batch
+
+  std::vector<std::thread> workers_;  // persistent worker threads
+};
+
+/**
+ * @brief Lock current and future pages into RAM
+ * @return true on success
+ * @details Prevents page faults from stalling the control loop.
+ */
+bool lock_memory();
+
+/**
+ * @brief Give the calling thread SCHED_FIFO real-time priority
+ * @param priority - SCHED_FIFO priority [1 99]
+ * @return true on success
+ */
+bool set_thread_priority(int priority);
+
+/**
+ * @brief Pin the calling thread to a CPU
+ * @param cpu - zero based CPU index
+ * @return true on success
+ */
+bool set_cpu_affinity(int cpu);
+}  // namespace realtime
+}  // namespace quadruped_controller
+#endif
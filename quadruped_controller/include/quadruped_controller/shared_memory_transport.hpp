@@ -0,0 +1,190 @@
+/**
+ * @file shared_memory_transport.hpp
+ * @date 2021-10-02
+ * @author Boston Cleek
+ * @brief Zero-copy shared-memory transport for fixed-size state snapshots
+ */
+#ifndef SHARED_MEMORY_TRANSPORT_HPP
+#define SHARED_MEMORY_TRANSPORT_HPP
+
+// C++
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Linux
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <ros/console.h>
+
+namespace quadruped_controller
+{
+namespace shm
+{
+/** @brief Joint states snapshot, joints follow the joint_states topic order */
+struct JointStateSnapshot
+{
+  uint64_t stamp_ns;     // monotonic publish time (ns)
+  double position[12];   // joint positions (rad)
+  double velocity[12];   // joint velocities (rad/s)
+};
+
+/** @brief CoM pose and velocity twist snapshot in world frame */
+struct CoMStateSnapshot
+{
+  uint64_t stamp_ns;           // monotonic publish time (ns)
+  double orientation[4];       // [qw, qx, qy, qz]
+  double position[3];          // [x, y, z]
+  double linear_velocity[3];   // [vx, vy, vz]
+  double angular_velocity[3];  // [wx, wy, wz]
+};
+
+/** @brief Joint torque command snapshot in the canonical actuator order */
+struct JointTorqueSnapshot
+{
+  uint64_t stamp_ns;  // monotonic publish time (ns)
+  double torque[12];  // joint torques (N*m)
+};
+
+/**
+ * @brief Single-writer shared-memory channel for one POD snapshot type
+ * @tparam T - trivially copyable snapshot struct
+ * @details The channel maps a POSIX shared-memory segment holding a
+ * sequence counter and one snapshot slot (seqlock). The writer publishes
+ * with a single struct copy and two counter stores; readers copy the slot
+ * and retry on a torn read. Either side may open the channel first: the
+ * segment is created on demand and zero-filled, a sequence of zero means
+ * nothing has been published yet. There is no serialization and no
+ * per-message allocation.
+ */
+template <typename T>
+class Channel
+{
+public:
+  /**
+   * @brief Constructor
+   * @param name - shared-memory segment name (e.g. "/quadruped_com_state")
+   */
+  explicit Channel(const std::string& name) : name_(name), slot_(nullptr)
+  {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "shared-memory snapshots must be trivially copyable");
+
+    const auto fd = shm_open(name_.c_str(), O_CREAT | O_RDWR, 0666);
+    if (fd < 0)
+    {
+      ROS_ERROR_NAMED("shm_transport", "Failed to open shared memory: %s",
+                      name_.c_str());
+      return;
+    }
+
+    // A fresh segment is zero-filled so the sequence starts at zero
+    if (ftruncate(fd, sizeof(Slot)) != 0)
+    {
+      ROS_ERROR_NAMED("shm_transport", "Failed to size shared memory: %s",
+                      name_.c_str());
+      close(fd);
+      return;
+    }
+
+    void* mem = mmap(nullptr, sizeof(Slot), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (mem == MAP_FAILED)
+    {
+      ROS_ERROR_NAMED("shm_transport", "Failed to map shared memory: %s",
+                      name_.c_str());
+      return;
+    }
+
+    slot_ = static_cast<Slot*>(mem);
+  }
+
+  ~Channel()
+  {
+    if (slot_ != nullptr)
+    {
+      munmap(slot_, sizeof(Slot));
+    }
+  }
+
+  Channel(const Channel&) = delete;
+  Channel& operator=(const Channel&) = delete;
+
+  /** @brief Return true if the segment mapped successfully */
+  bool valid() const
+  {
+    return slot_ != nullptr;
+  }
+
+  /**
+   * @brief Publish a snapshot
+   * @param value - snapshot contents
+   * @details Must only be called from a single writer process.
+   */
+  void write(const T& value)
+  {
+    const auto seq = slot_->sequence.load(std::memory_order_relaxed);
+    slot_->sequence.store(seq + 1, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::memcpy(&slot_->data, &value, sizeof(T));
+
+    std::atomic_thread_fence(std::memory_order_release);
+    slot_->sequence.store(seq + 2, std::memory_order_release);
+  }
+
+  /**
+   * @brief Retrieve the latest snapshot
+   * @param value[out] - snapshot contents
+   * @return true if a snapshot has ever been published
+   */
+  bool read(T& value) const
+  {
+    uint64_t seq_before = 0;
+    uint64_t seq_after = 0;
+
+    do
+    {
+      seq_before = slot_->sequence.load(std::memory_order_acquire);
+      if (seq_before == 0)
+      {
+        return false;  // nothing published yet
+      }
+
+      if (seq_before & 1u)
+      {
+        continue;  // write in progress
+      }
+
+      std::memcpy(&value, &slot_->data, sizeof(T));
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      seq_after = slot_->sequence.load(std::memory_order_acquire);
+    } while (seq_before != seq_after);
+
+    return true;
+  }
+
+private:
+  struct Slot
+  {
+    std::atomic<uint64_t> sequence;  // even when stable, odd mid-write
+    T data;                          // snapshot slot
+  };
+
+  std::string name_;  // shared-memory segment name
+  Slot* slot_;        // mapped segment
+};
+
+// Segment names shared between the simulation interface and the commander
+inline const std::string JOINT_STATE_CHANNEL = "/quadruped_joint_states";
+inline const std::string COM_STATE_CHANNEL = "/quadruped_com_state";
+inline const std::string JOINT_TORQUE_CHANNEL = "/quadruped_joint_torque_cmd";
+}  // namespace shm
+}  // namespace quadruped_controller
+#endif
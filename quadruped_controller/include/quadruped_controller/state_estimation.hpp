@@ -0,0 +1,101 @@
+/**
+ * @file state_estimation.hpp
+ * @date 2021-10-23
+ * @author Boston Cleek
+ * @brief Contact-aided state estimation
+ */
+#ifndef STATE_ESTIMATION_HPP
+#define STATE_ESTIMATION_HPP
+
+// C++
+#include <array>
+
+// Quadruped Control
+#include <quadruped_controller/kinematics.hpp>
+#include <quadruped_controller/math/rigid3d.hpp>
+#include <quadruped_controller/types.hpp>
+
+namespace quadruped_controller
+{
+using arma::mat;
+using arma::mat33;
+using arma::vec;
+using arma::vec3;
+
+using math::Quaternion;
+
+/**
+ * @brief Contact-aided kalman filter fusing IMU and leg odometry
+ * @details The filter state is the COM position and linear velocity
+ * (6x1). Orientation and angular velocity are taken from the IMU. The
+ * prediction integrates the IMU specific force and the correction
+ * treats every foot in contact as stationary, measuring the base
+ * velocity through the leg jacobians and the base height through
+ * forward kinematics. Feet within a tolerance of the lowest foot are
+ * considered in contact. All matrices are fixed-size stack storage so
+ * an update never allocates.
+ */
+class StateEstimator
+{
+public:
+  /**
+   * @brief Constructor
+   * @param sigma_accel - accelerometer noise density (m/s^2)
+   * @param sigma_foot_velocity - leg odometry velocity noise (m/s)
+   * @param sigma_foot_height - leg odometry height noise (m)
+   * @param contact_tolerance - feet within this height of the lowest foot
+   *  are treated as in contact (m)
+   */
+  StateEstimator(double sigma_accel, double sigma_foot_velocity,
+                 double sigma_foot_height, double contact_tolerance);
+
+  /**
+   * @brief Set the initial state
+   * @param x - COM position in world [x, y, z] (3x1)
+   * @param xdot - COM linear velocity in world [vx, vy, vz] (3x1)
+   */
+  void initialize(const vec3& x, const vec3& xdot);
+
+  /**
+   * @brief Predict and correct the filter state
+   * @param dt - time since the last update (s)
+   * @param orientation - base orientation in world from the IMU
+   * @param accel - specific force in body frame (m/s^2)
+   * @param gyro - angular velocity in body frame (rad/s)
+   * @param joint_states_map - map leg names to joint states
+   */
+  void update(double dt, const Quaternion& orientation, const vec3& accel,
+              const vec3& gyro, const JointStatesMap& joint_states_map);
+
+  /** @brief Retrieve the estimated COM state */
+  const RobotStateCoM& state() const;
+
+private:
+  /**
+   * @brief Detect feet in contact with the ground
+   * @param ft_p - foot positions relative to base_link per column (3x4)
+   * @param contacts[out] - true for feet in contact
+   * @details A foot is in contact when its world frame height is within
+   * the contact tolerance of the lowest foot. At least one foot is
+   * always in contact.
+   */
+  void detectContacts(const mat::fixed<3, 4>& ft_p,
+                      std::array<bool, NUM_LEGS>& contacts) const;
+
+private:
+  QuadrupedKinematics kinematics_;  // leg odometry primitives
+
+  // Noise parameters
+  double sigma_accel_;          // accelerometer noise density (m/s^2)
+  double sigma_foot_velocity_;  // leg odometry velocity noise (m/s)
+  double sigma_foot_height_;    // leg odometry height noise (m)
+  double contact_tolerance_;    // contact detection height tolerance (m)
+
+  vec3 g_;  // gravity vector in world frame (m/s^2)
+
+  bool initialized_;       // initial state set
+  RobotStateCoM state_;    // estimated COM state
+  mat::fixed<6, 6> P_;     // state covariance [p, v]
+};
+}  // namespace quadruped_controller
+#endif
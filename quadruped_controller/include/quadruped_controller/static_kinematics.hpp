@@ -0,0 +1,253 @@
+/**
+ * @file static_kinematics.hpp
+ * @date 2021-11-13
+ * @author Boston Cleek
+ * @brief Compile-time specialized quadruped kinematics
+ */
+#ifndef STATIC_KINEMATICS_HPP
+#define STATIC_KINEMATICS_HPP
+
+// C++
+#include <array>
+#include <cmath>
+
+#include <quadruped_controller/types.hpp>
+
+namespace quadruped_controller
+{
+/**
+ * @brief Compile-time leg geometry descriptor
+ * @details All values are magnitudes: the per-leg signs for the hip
+ * offsets and link lengths follow from the leg id. The robot is assumed
+ * symmetric about the body x and y axes, matching the runtime model in
+ * QuadrupedKinematics.
+ */
+struct KinematicsModel
+{
+  double hip_x;  // base to hip translation x (m)
+  double hip_y;  // base to hip translation y (m)
+  double hip_z;  // base to hip translation z (m)
+  double l1;     // hip link length (m)
+  double l2;     // thigh link length (m)
+  double l3;     // calf link length (m)
+};
+
+/** @brief Geometry of the MIT mini cheetah based robot */
+inline constexpr KinematicsModel MIT_CHEETAH_MODEL = { 0.196,  0.050,  0.0,
+                                                       0.077,  0.211,  0.230 };
+
+/**
+ * @brief Kinematic model with the leg geometry fixed at compile time
+ * @tparam Model - constexpr geometry descriptor
+ * @details Mirrors the per-leg API of QuadrupedKinematics but takes the
+ * geometry from a constexpr descriptor instead of a runtime map, so the
+ * compiler constant-folds the link lengths and hip offsets straight into
+ * the trig kernels and every call can inline into the control loop.
+ * Keep using QuadrupedKinematics when the geometry comes from a URDF at
+ * runtime; select the descriptor per robot at build time.
+ */
+template <KinematicsModel Model>
+class StaticKinematics
+{
+public:
+  /** @brief Signed base to hip translation x for a leg */
+  static constexpr double hipX(LegId id)
+  {
+    return (id == FL || id == FR) ? Model.hip_x : -Model.hip_x;
+  }
+
+  /** @brief Signed base to hip translation y for a leg */
+  static constexpr double hipY(LegId id)
+  {
+    return (id == RL || id == FL) ? Model.hip_y : -Model.hip_y;
+  }
+
+  /** @brief Base to hip translation z for a leg */
+  static constexpr double hipZ(LegId)
+  {
+    return Model.hip_z;
+  }
+
+  /** @brief Signed hip link length for a leg */
+  static constexpr double l1(LegId id)
+  {
+    return (id == RL || id == FL) ? Model.l1 : -Model.l1;
+  }
+
+  /** @brief Signed thigh link length */
+  static constexpr double l2()
+  {
+    return -Model.l2;
+  }
+
+  /** @brief Signed calf link length */
+  static constexpr double l3()
+  {
+    return -Model.l3;
+  }
+
+  /**
+   * @brief Compose the position of a single foot in body frame
+   * @param id - leg id
+   * @param q - joint angles [hip, thigh, calf]
+   * @return position of the foot relative to base_link [x, y, z]
+   */
+  static vec3 forwardKinematics(LegId id, const vec3& q)
+  {
+    const auto s1 = std::sin(q(0));
+    const auto c1 = std::cos(q(0));
+    const auto s2 = std::sin(q(1));
+    const auto s23 = std::sin(q(1) + q(2));
+    const auto c2 = std::cos(q(1));
+    const auto c23 = std::cos(q(1) + q(2));
+
+    vec3 foot_position;
+    foot_position(0) = l2() * s2 + l3() * s23 + hipX(id);
+    foot_position(1) = l1(id) * c1 - l2() * s1 * c2 - l3() * s1 * c23 + hipY(id);
+    foot_position(2) = l1(id) * s1 + l2() * c1 * c2 + l3() * c1 * c23 + hipZ(id);
+
+    return foot_position;
+  }
+
+  /**
+   * @brief Inverse kinematics for a single leg
+   * @param id - leg id
+   * @param foothold - position of foot relative to base_link [x, y, z]
+   * @return leg joint angles [hip, thigh, calf]
+   */
+  static vec3 legInverseKinematics(LegId id, const vec3& foothold)
+  {
+    // position of foot relative to hip
+    const auto x = foothold(0) - hipX(id);
+    const auto y = foothold(1) - hipY(id);
+    const auto z = foothold(2) - hipZ(id);
+
+    constexpr auto l1_mag = Model.l1;
+    constexpr auto l2_mag = Model.l2;
+    constexpr auto l3_mag = Model.l3;
+    constexpr auto d_scale = 1.0 / (2.0 * l2_mag * l3_mag);
+    constexpr auto length_sq =
+        l1_mag * l1_mag + l2_mag * l2_mag + l3_mag * l3_mag;
+
+    auto d = (x * x + y * y + z * z - length_sq) * d_scale;
+
+    if (d > 1.0)
+    {
+      d = 1.0;
+    }
+
+    auto sqrt_component = y * y + z * z - l1_mag * l1_mag;
+    if (sqrt_component < 0.0)
+    {
+      sqrt_component = 0.0;
+    }
+
+    vec3 q;
+
+    if (id == RR || id == FR)
+    {
+      q(0) = std::atan2(z, y) + std::atan2(std::sqrt(sqrt_component), -l1_mag);
+    }
+    else
+    {
+      q(0) = -(std::atan2(z, -y) + std::atan2(std::sqrt(sqrt_component), -l1_mag));
+    }
+
+    q(2) = std::atan2(-std::sqrt(1.0 - d * d), d);
+    q(1) = -std::atan2(x, std::sqrt(sqrt_component)) -
+           std::atan2(l3_mag * std::sin(q(2)), l2_mag + l3_mag * std::cos(q(2)));
+
+    return q;
+  }
+
+  /**
+   * @brief Compose the geometric jacobian for a single leg
+   * @param id - leg id
+   * @param q - leg joint angles [hip, thigh, calf]
+   * @return single leg jacobian (3x3)
+   */
+  static mat33 legJacobian(LegId id, const vec3& q)
+  {
+    const auto s1 = std::sin(q(0));
+    const auto c1 = std::cos(q(0));
+    const auto s2 = std::sin(q(1));
+    const auto s23 = std::sin(q(1) + q(2));
+    const auto c2 = std::cos(q(1));
+    const auto c23 = std::cos(q(1) + q(2));
+
+    mat33 jac;
+    jac(0, 0) = 0.0;
+    jac(0, 1) = l2() * c2 + l3() * c23;
+    jac(0, 2) = l3() * c23;
+
+    jac(1, 0) = -l1(id) * s1 - l2() * c1 * c2 - l3() * c1 * c23;
+    jac(1, 1) = (l2() * s2 + l3() * s23) * s1;
+    jac(1, 2) = l3() * s1 * s23;
+
+    jac(2, 0) = l1(id) * c1 - l2() * s1 * c2 - l3() * s1 * c23;
+    jac(2, 1) = -(l2() * s2 + l3() * s23) * c1;
+    jac(2, 2) = -l3() * s23 * c1;
+
+    return jac;
+  }
+
+  /**
+   * @brief Compose the geometric jacobian inverse for a single leg
+   * @param id - leg id
+   * @param q - leg joint angles [hip, thigh, calf]
+   * @return single leg jacobian inverse (3x3)
+   * @details If the jacobian is singular the Moore-Penrose pseudo-inverse
+   * is returned. If the pseudo-inverse cannot be solved for within
+   * tolerance then the transpose is returned.
+   */
+  static mat33 legJacobianInverse(LegId id, const vec3& q)
+  {
+    mat33 Jinv;
+    const mat33 J = legJacobian(id, q);
+    if (!arma::inv(Jinv, J))
+    {
+      if (!arma::pinv(Jinv, J))
+      {
+        Jinv = J.t();
+      }
+    }
+
+    return Jinv;
+  }
+
+  /**
+   * @brief Batched forward kinematics for all four legs
+   * @param q - joint angles [hip, thigh, calf], one column per leg [RL FL RR FR] (3x4)
+   * @param ft_p[out] - foot positions [x, y, z] relative to base_link per column (3x4)
+   */
+  static void forwardKinematicsAll(const mat::fixed<3, 4>& q, mat::fixed<3, 4>& ft_p)
+  {
+    for (unsigned int i = 0; i < NUM_LEGS; i++)
+    {
+      ft_p.col(i) = forwardKinematics(static_cast<LegId>(i), q.col(i));
+    }
+  }
+
+  /**
+   * @brief Batched geometric jacobians for all four legs
+   * @param q - joint angles [hip, thigh, calf], one column per leg (3x4)
+   * @param jacobians[out] - jacobian per leg indexed by LegId (3x3 each)
+   */
+  static void jacobiansAll(const mat::fixed<3, 4>& q,
+                           std::array<mat33, NUM_LEGS>& jacobians)
+  {
+    for (unsigned int i = 0; i < NUM_LEGS; i++)
+    {
+      jacobians.at(i) = legJacobian(static_cast<LegId>(i), q.col(i));
+    }
+  }
+};
+
+/** @brief Kinematics specialization selected at build time per robot */
+#ifdef QUADRUPED_KINEMATICS_MODEL
+using RobotKinematics = StaticKinematics<QUADRUPED_KINEMATICS_MODEL>;
+#else
+using RobotKinematics = StaticKinematics<MIT_CHEETAH_MODEL>;
+#endif
+}  // namespace quadruped_controller
+#endif
@@ -0,0 +1,103 @@
+/**
+ * @file telemetry.hpp
+ * @date 2021-10-30
+ * @author Boston Cleek
+ * @brief Memory-mapped binary telemetry logging
+ */
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+// C++
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace quadruped_controller
+{
+namespace telemetry
+{
+/** @brief Fixed-schema controller telemetry record, legs follow [RL FL RR FR] */
+struct TelemetryRecord
+{
+  uint64_t stamp_ns;                   // monotonic time (ns)
+  double orientation[4];               // COM orientation [qw, qx, qy, qz]
+  double position[3];                  // COM position (m)
+  double linear_velocity[3];           // COM linear velocity (m/s)
+  double angular_velocity[3];          // COM angular velocity (rad/s)
+  double position_desired[3];          // desired COM position (m)
+  double linear_velocity_desired[3];   // desired COM linear velocity (m/s)
+  double angular_velocity_desired[3];  // desired COM angular velocity (rad/s)
+  double grf[12];                      // GRFs in body frame (N), zero in swing
+  double torque[12];                   // joint torques (N*m)
+  double gait_phase[4];                // leg phases [0 1)
+  uint32_t leg_state[4];               // 0 = stance, 1 = swing
+  uint32_t qp_failures;                // consecutive failed QP solves
+  uint32_t reserved;                   // keeps the record 8 byte aligned
+};
+
+/** @brief On-disk file header followed by the record ring */
+struct TelemetryFileHeader
+{
+  char magic[8];                   // "QCTLOG1" identifies the schema
+  uint32_t record_size;            // sizeof(TelemetryRecord)
+  uint32_t capacity;               // records in the ring
+  std::atomic<uint64_t> written;   // total records ever written
+};
+
+/** @brief Expected file magic */
+constexpr char TELEMETRY_MAGIC[8] = "QCTLOG1";
+
+/**
+ * @brief Fixed-schema binary ring buffer backed by a memory-mapped file
+ * @details The control loop writes one record per tick with a single
+ * memcpy into the mapped ring followed by a counter store - no
+ * serialization, locking, or syscalls on the hot path. A background
+ * thread flushes the mapping to disk at a low rate; because the ring
+ * lives in a file mapping the kernel also writes it back if the node
+ * crashes, so the last seconds before a fault are recoverable.
+ */
+class TelemetryLogger
+{
+public:
+  /**
+   * @brief Constructor
+   * @param path - log file path
+   * @param capacity - records in the ring (oldest are overwritten)
+   * @param flush_period - background flush period (s)
+   */
+  TelemetryLogger(const std::string& path, uint32_t capacity, double flush_period);
+
+  /** @brief Destructor, flushes and unmaps the ring */
+  ~TelemetryLogger();
+
+  TelemetryLogger(const TelemetryLogger&) = delete;
+  TelemetryLogger& operator=(const TelemetryLogger&) = delete;
+
+  /** @brief Return true if the file mapped successfully */
+  bool valid() const;
+
+  /**
+   * @brief Append a record to the ring
+   * @param record - telemetry record
+   */
+  void log(const TelemetryRecord& record);
+
+private:
+  /** @brief Background flush loop */
+  void flushLoop();
+
+private:
+  std::string path_;              // log file path
+  uint32_t capacity_;             // records in the ring
+  double flush_period_;           // background flush period (s)
+  size_t map_size_;               // total mapping size (bytes)
+  TelemetryFileHeader* header_;   // mapped file header
+  TelemetryRecord* records_;      // mapped record ring
+
+  std::atomic_bool flushing_;     // flush thread runs while true
+  std::thread flush_thread_;      // background flush thread
+};
+}  // namespace telemetry
+}  // namespace quadruped_controller
+#endif
@@ -0,0 +1,109 @@
+/**
+ * @file terrain.hpp
+ * @date 2021-11-06
+ * @author Boston Cleek
+ * @brief Terrain heightmap with precomputed foothold index
+ */
+#ifndef TERRAIN_HPP
+#define TERRAIN_HPP
+
+#include <quadruped_controller/types.hpp>
+
+namespace quadruped_controller
+{
+/**
+ * @brief 2D terrain heightmap with an O(1) grid index
+ * @details The terrain is a regular grid of cell heights in the world
+ * frame. Surface normals and a foothold cost per cell are precomputed
+ * whenever the heights are updated, so every query on the control path
+ * is a bounded-time array lookup - no tree traversal. Queries outside
+ * the grid fall back to flat ground at z = 0, and a default constructed
+ * map is entirely flat, preserving the planar Raibert heuristic.
+ */
+class TerrainMap
+{
+public:
+  /** @brief Constructor, flat ground at z = 0 everywhere */
+  TerrainMap();
+
+  /**
+   * @brief Constructor
+   * @param origin - world position [x, y] of cell (0,0) center (m)
+   * @param resolution - cell edge length (m)
+   * @param rows - number of cells along x
+   * @param cols - number of cells along y
+   * @param cost_max - max foothold cost before a cell is rejected
+   * @details The foothold cost of a cell is (1 - nz) of its surface
+   * normal: 0 on flat ground and approaching 1 on a vertical face.
+   */
+  TerrainMap(const vec& origin, double resolution, unsigned int rows, unsigned int cols,
+             double cost_max = 0.3);
+
+  /**
+   * @brief Update cell heights from an external mapping source
+   * @param heights - cell heights (rows x cols) (m)
+   * @details Recomputes the surface-normal and foothold-cost index.
+   * Not safe to call concurrently with queries.
+   */
+  void update(const mat& heights);
+
+  /**
+   * @brief Terrain height under a world position
+   * @param x - world x position (m)
+   * @param y - world y position (m)
+   * @return cell height (m), 0 outside the grid
+   */
+  double height(double x, double y) const;
+
+  /**
+   * @brief Surface normal under a world position
+   * @param x - world x position (m)
+   * @param y - world y position (m)
+   * @return unit surface normal, +z outside the grid
+   */
+  vec3 normal(double x, double y) const;
+
+  /**
+   * @brief Foothold cost under a world position
+   * @param x - world x position (m)
+   * @param y - world y position (m)
+   * @return precomputed cell cost, 0 outside the grid
+   */
+  double cost(double x, double y) const;
+
+  /**
+   * @brief Snap a candidate foothold to valid terrain
+   * @param foothold - candidate foothold in world frame
+   * @return foothold on the terrain surface
+   * @details Sets the foothold height from the grid. If the candidate
+   * cell cost exceeds the limit the cheapest cell in a fixed 5x5
+   * neighborhood is used instead, keeping the query bounded-time.
+   */
+  vec3 snap(const vec3& foothold) const;
+
+private:
+  /**
+   * @brief Locate the cell under a world position
+   * @param x - world x position (m)
+   * @param y - world y position (m)
+   * @param i[out] - cell row
+   * @param j[out] - cell column
+   * @return true if the position is inside the grid
+   */
+  bool cellIndex(double x, double y, unsigned int& i, unsigned int& j) const;
+
+private:
+  arma::vec2 origin_;  // world position of cell (0,0) center (m)
+  double resolution_;  // cell edge length (m)
+  unsigned int rows_;  // cells along x
+  unsigned int cols_;  // cells along y
+  double cost_max_;    // max acceptable foothold cost
+
+  mat heights_;    // cell heights (rows x cols) (m)
+  mat normals_x_;  // surface normal x components
+  mat normals_y_;  // surface normal y components
+  mat normals_z_;  // surface normal z components
+  mat costs_;      // foothold cost per cell
+};
+}  // namespace quadruped_controller
+#endif
@@ -17,6 +17,7 @@
 namespace quadruped_controller
 {
 using arma::mat;
+using arma::mat33;
 using arma::vec;
 using arma::vec3;
 
@@ -54,22 +55,116 @@ Pose integrate_twist_yaw(const Pose& pose, const vec& u, double dt);
 //   unsigned int i{ 0 };
 // };
 
-/** @brief COM reference trajectory generator */
-// class BaseTrajectory
-// {
-// public:
-//   BaseTrajectory();
+/**
+ * @brief Incremental COM reference trajectory generator
+ * @details The commanded body twist is shaped by a first-order filter
+ * with acceleration limits and the reference pose is integrated every
+ * control tick from cached yaw state - no transforms or adjoints are
+ * rebuilt and nothing allocates on the hot path. Only [vx, vy, wz] of
+ * the command are tracked: roll and pitch are held at zero and the
+ * height is pinned to the reset value so the reference cannot drift.
+ * Smooth references keep the GRF QP warm starts close to optimal.
+ */
+class BaseTrajectory
+{
+public:
+  /**
+   * @brief Constructor
+   * @param dt - control tick the reference advances by (s)
+   * @param linear_accel_max - linear acceleration limit (m/s^2)
+   * @param angular_accel_max - angular acceleration limit (rad/s^2)
+   * @param filter_cutoff - velocity command shaping cutoff (Hz)
+   */
+  BaseTrajectory(double dt, double linear_accel_max, double angular_accel_max,
+                 double filter_cutoff);
 
-// private:
-// };
+  /**
+   * @brief Reset the reference onto the actual state
+   * @param x - COM position in world [x, y, z]
+   * @param yaw - yaw angle (rad)
+   * @param height - reference height held by the trajectory (m)
+   * @details Zeros the shaped velocities, call when the gait starts.
+   */
+  void reset(const vec3& x, double yaw, double height);
+
+  /**
+   * @brief Shape the command and advance the reference one tick
+   * @param vb_cmd - commanded body twist [vx, vy, vz, wx, wy, wz]
+   */
+  void advance(const vec::fixed<6>& vb_cmd);
+
+  /** @brief Desired rotation from world to base_link (yaw only) */
+  const mat33& rotation() const;
+
+  /** @brief Desired COM position in world */
+  const vec3& position() const;
+
+  /** @brief Desired COM linear velocity in world */
+  const vec3& linearVelocity() const;
+
+  /** @brief Desired COM angular velocity in world */
+  const vec3& angularVelocity() const;
+
+  /**
+   * @brief Sample the reference over a prediction horizon
+   * @param dt - horizon step (s)
+   * @param steps - number of steps, N, in the horizon
+   * @param x_ref[out] - reference sequence [theta, p, w, pdot, g] per step (13N x 1)
+   * @details Integrates the shaped twist forward from the current
+   * reference in the state layout the MPC consumes. The output is
+   * resized only when the horizon length changes.
+   */
+  void sampleHorizon(double dt, unsigned int steps, vec& x_ref) const;
+
+private:
+  /** @brief Update the cached yaw rotation state */
+  void updateRotation();
+
+private:
+  double dt_;                 // control tick (s)
+  double linear_accel_max_;   // linear acceleration limit (m/s^2)
+  double angular_accel_max_;  // angular acceleration limit (rad/s^2)
+  double alpha_;              // first-order shaping constant [0 1]
 
-/** @brief Virtual support polygon */
+  // Shaped body twist [vx, vy, wz]
+  double vx_{ 0.0 };
+  double vy_{ 0.0 };
+  double wz_{ 0.0 };
+
+  // Cached reference pose state
+  double yaw_{ 0.0 };     // reference yaw (rad)
+  double height_{ 0.0 };  // pinned reference height (m)
+  mat33 Rwb_d_;           // reference rotation (yaw only)
+  vec3 x_d_;              // reference position in world
+  vec3 xdot_d_;           // reference linear velocity in world
+  vec3 w_d_;              // reference angular velocity in world
+};
+
+/**
+ * @brief Virtual support polygon
+ * @details Adjacency over the fixed four-leg ordering is precomputed as
+ * LegId indices so composing the support position is direct array
+ * lookups and scalar arithmetic - no string comparisons, no branches on
+ * the hot path beyond the per-leg contact select, and no allocations.
+ */
 class SupportPolygon
 {
 public:
   /** @brief Constructor */
   SupportPolygon();
 
+  /**
+   * @brief Compose COM position
+   * @param phase_map - map leg names to scheduled contact and swing phases
+   * @param foot_map - map leg names to current foot positions
+   * @param gait_map - scheduled gait
+   * @param zeta[out] - x,y COM position (2x1)
+   * @details All four legs must be present in every map. The output is
+   * resized only if it does not already hold two elements.
+   */
+  void position(const ScheduledPhasesMap& phase_map, const FootholdMap& foot_map,
+                const GaitMap& gait_map, vec& zeta) const;
+
   /**
    * @brief Compose COM position
    * @param phase_map - map leg names to scheduled contact and swing phases
@@ -81,8 +176,9 @@ public:
                const GaitMap& gait_map) const;
 
 private:
-  // maps leg name to adjacent legs (in order clockwise and counter clockwise)
-  std::map<std::string, std::pair<std::string, std::string>> adjacent_leg_map_;
+  // adjacent legs indexed by LegId (in order clockwise and counter clockwise)
+  std::array<LegId, NUM_LEGS> clockwise_;
+  std::array<LegId, NUM_LEGS> counter_clockwise_;
 };
 
 /** @brief Generates a trajectory for a single foot */
@@ -100,7 +196,9 @@ public:
    * @return true if the trajectory is successfully generated
    * @details The trajectory is generated using a sextic polynomial and consists
    * of the foot's position and velocity on the time domain [0 1]. The initial and
-   * terminal velocities and accelerations are zero.
+   * terminal velocities and accelerations are zero. The boundary condition
+   * system is constant on [0 1] so replanning is a single 7x3 multiply
+   * against its precomputed inverse.
    */
   bool generateTrajetory(const vec3& p_start, const vec3& p_center,
                          const vec3& p_final) const;
@@ -109,17 +207,13 @@ public:
    * @brief Retrieve the foot state at a given time
    * @param t - time [0 1]
    * @return desired position and velocity of foot
+   * @details The position and velocity polynomials are evaluated in
+   * Horner form sharing the time basis across the three coordinates.
+   * Tracking never touches the heap.
    */
   FootState trackTrajectory(double t) const;
 
 private:
-  /**
-   * @brief Construct system of equations
-   * @return system (7x7)
-   * @details In a linear system AX = B, this constructs A
-   */
-  mat initSystem() const;
-
   /**
    * @brief Construct constant terms
    * @param p_start - foot start position [x y z]
@@ -128,11 +222,11 @@ private:
    * @return constant terms (7x3)
    * @details In a linear system AX = B, this constructs B
    */
-  mat constantTerms(const vec3& p_start, const vec3& p_center, const vec3& p_final) const;
+  mat::fixed<7, 3> constantTerms(const vec3& p_start, const vec3& p_center,
+                                 const vec3& p_final) const;
 
 private:
-  mat A_;                     // system (7x7)
-  mutable mat coefficients_;  // polynomial coefficients (7x3)
+  mutable mat::fixed<7, 3> coefficients_;  // polynomial coefficients (7x3)
 };
 
 /** @brief Manages foot trajectories */
@@ -183,8 +277,7 @@ private:
   double stance_phase_;  // when stance phase ends [0 1)
   double slope_;         // scale trajectory via interpolation
   double y_intercept_;   // scale trajectory via interpolation
-  mutable std::map<std::string, FootTrajectory>
-      traj_map_;  // map leg name to foot trajectory
+  mutable LegMap<FootTrajectory> traj_map_;  // map leg to foot trajectory
 };
 
 }  // namespace quadruped_controller
@@ -9,7 +9,8 @@
 #define TYPES_HPP
 
 // C++
-#include <map>
+#include <array>
+#include <stdexcept>
 #include <utility>
 #include <string>
 
@@ -23,6 +24,278 @@ using arma::mat33;
 using arma::vec;
 using arma::vec3;
 
+/** @brief Leg index in the canonical leg order [RL FL RR FR] */
+enum LegId : unsigned int
+{
+  RL = 0,
+  FL = 1,
+  RR = 2,
+  FR = 3
+};
+
+/** @brief Number of legs */
+constexpr unsigned int NUM_LEGS = 4;
+
+/** @brief Leg names indexed by LegId */
+inline const std::array<std::string, NUM_LEGS> LEG_NAMES = { "RL", "FL", "RR", "FR" };
+
+/**
+ * @brief Map a leg name to its LegId
+ * @param leg_name - leg name ("RL", "FL", "RR", or "FR")
+ * @return leg index
+ * @details Throws std::out_of_range if the leg name is invalid.
+ */
+inline LegId leg_id(const std::string& leg_name)
+{
+  if (leg_name.size() == 2)
+  {
+    if (leg_name[0] == 'R')
+    {
+      if (leg_name[1] == 'L')
+      {
+        return LegId::RL;
+      }
+      else if (leg_name[1] == 'R')
+      {
+        return LegId::RR;
+      }
+    }
+    else if (leg_name[0] == 'F')
+    {
+      if (leg_name[1] == 'L')
+      {
+        return LegId::FL;
+      }
+      else if (leg_name[1] == 'R')
+      {
+        return LegId::FR;
+      }
+    }
+  }
+
+  throw std::out_of_range("Invalid leg name: " + leg_name);
+}
+
+/**
+ * @brief Fixed four-leg container with a map-like API
+ * @tparam T - value stored per leg
+ * @details Replaces std::map<std::string, T> on the control hot path.
+ * Storage is a contiguous std::array indexed by LegId so lookups are
+ * O(1) with no string comparisons and insertion never allocates.
+ * Entries may be absent (like a map) which is tracked in a bitmask.
+ * Iteration visits the present legs in the canonical leg order and
+ * yields (leg name, value) pairs to remain compatible with the
+ * std::map interface it replaces.
+ */
+template <typename T>
+class LegMap
+{
+public:
+  LegMap() : present_{ false, false, false, false }
+  {
+  }
+
+  /** @brief Iterator over present legs yielding (leg name, value) pairs */
+  template <bool IsConst>
+  class Iterator
+  {
+  public:
+    using map_type = std::conditional_t<IsConst, const LegMap, LegMap>;
+    using value_type = std::conditional_t<IsConst, std::pair<const std::string&, const T&>,
+                                          std::pair<const std::string&, T&>>;
+
+    Iterator(map_type* map, unsigned int i) : map_(map), i_(i)
+    {
+      advance();
+    }
+
+    value_type operator*() const
+    {
+      return { LEG_NAMES.at(i_), map_->data_.at(i_) };
+    }
+
+    Iterator& operator++()
+    {
+      i_++;
+      advance();
+      return *this;
+    }
+
+    bool operator==(const Iterator& other) const
+    {
+      return i_ == other.i_;
+    }
+
+    bool operator!=(const Iterator& other) const
+    {
+      return i_ != other.i_;
+    }
+
+  private:
+    /** @brief Skip legs without an entry */
+    void advance()
+    {
+      while (i_ < NUM_LEGS && !map_->present_.at(i_))
+      {
+        i_++;
+      }
+    }
+
+    map_type* map_;
+    unsigned int i_;
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  /** @brief Access value by leg id */
+  T& at(LegId id)
+  {
+    if (!present_.at(id))
+    {
+      throw std::out_of_range("No entry for leg: " + LEG_NAMES.at(id));
+    }
+
+    return data_.at(id);
+  }
+
+  const T& at(LegId id) const
+  {
+    if (!present_.at(id))
+    {
+      throw std::out_of_range("No entry for leg: " + LEG_NAMES.at(id));
+    }
+
+    return data_.at(id);
+  }
+
+  /** @brief Access value by leg name */
+  T& at(const std::string& leg_name)
+  {
+    return at(leg_id(leg_name));
+  }
+
+  const T& at(const std::string& leg_name) const
+  {
+    return at(leg_id(leg_name));
+  }
+
+  /** @brief Access value by leg id, default constructing if absent */
+  T& operator[](LegId id)
+  {
+    present_.at(id) = true;
+    return data_.at(id);
+  }
+
+  /**
+   * @brief Insert a value for a leg if not already present
+   * @param leg_name - leg name
+   * @param args - arguments forwarded to the value constructor
+   * @return true if the value was inserted
+   */
+  template <typename... Args>
+  bool emplace(const std::string& leg_name, Args&&... args)
+  {
+    return emplace(leg_id(leg_name), std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  bool emplace(LegId id, Args&&... args)
+  {
+    if (present_.at(id))
+    {
+      return false;
+    }
+
+    data_.at(id) = T(std::forward<Args>(args)...);
+    present_.at(id) = true;
+    return true;
+  }
+
+  /** @brief Insert a range of (leg name, value) pairs */
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last)
+  {
+    for (; first != last; ++first)
+    {
+      const auto& kv = *first;
+      emplace(kv.first, kv.second);
+    }
+  }
+
+  /** @brief Find entry by leg name, returns end() if absent */
+  iterator find(const std::string& leg_name)
+  {
+    const auto id = leg_id(leg_name);
+    return present_.at(id) ? iterator(this, id) : end();
+  }
+
+  const_iterator find(const std::string& leg_name) const
+  {
+    const auto id = leg_id(leg_name);
+    return present_.at(id) ? const_iterator(this, id) : end();
+  }
+
+  /** @brief Return true if the leg has an entry */
+  bool contains(LegId id) const
+  {
+    return present_.at(id);
+  }
+
+  bool contains(const std::string& leg_name) const
+  {
+    return present_.at(leg_id(leg_name));
+  }
+
+  /** @brief Remove all entries, storage remains allocated in-place */
+  void clear()
+  {
+    present_ = { false, false, false, false };
+  }
+
+  /** @brief Return true if no leg has an entry */
+  bool empty() const
+  {
+    return !(present_[0] || present_[1] || present_[2] || present_[3]);
+  }
+
+  /** @brief Return number of legs with entries */
+  unsigned int size() const
+  {
+    unsigned int n = 0;
+    for (const auto present : present_)
+    {
+      n += present ? 1 : 0;
+    }
+
+    return n;
+  }
+
+  iterator begin()
+  {
+    return iterator(this, 0);
+  }
+
+  iterator end()
+  {
+    return iterator(this, NUM_LEGS);
+  }
+
+  const_iterator begin() const
+  {
+    return const_iterator(this, 0);
+  }
+
+  const_iterator end() const
+  {
+    return const_iterator(this, NUM_LEGS);
+  }
+
+private:
+  std::array<T, NUM_LEGS> data_;       // values in canonical leg order
+  std::array<bool, NUM_LEGS> present_;  // occupancy per leg
+};
+
 /** @brief CoM state */
 struct RobotStateCoM
 {
@@ -96,35 +369,35 @@ enum LegState
 
 //////////////////////////////////////////
 // Gait Types
-/** @brief map leg name to LegState and phase */
-typedef std::map<std::string, std::pair<LegState, double>> GaitMap;
+/** @brief map leg to LegState and phase */
+typedef LegMap<std::pair<LegState, double>> GaitMap;
 
-/** @brief map leg name to scheduled phases */
-typedef std::map<std::string, LegScheduledPhases> ScheduledPhasesMap;
+/** @brief map leg to scheduled phases */
+typedef LegMap<LegScheduledPhases> ScheduledPhasesMap;
 
 //////////////////////////////////////////
 // Foot Types
-/** @brief map leg name to desired foot placement in world frame */
-typedef std::map<std::string, vec3> FootholdMap;
+/** @brief map leg to desired foot placement in world frame */
+typedef LegMap<vec3> FootholdMap;
 
-/** @brief map leg name to foot position and velocity in world frame */
-typedef std::map<std::string, FootState> FootStateMap;
+/** @brief map leg to foot position and velocity in world frame */
+typedef LegMap<FootState> FootStateMap;
 
-/** @brief map leg name to foot trajectory boundary conditions */
-typedef std::map<std::string, FootTrajBounds> FootTrajBoundsMap;
+/** @brief map leg to foot trajectory boundary conditions */
+typedef LegMap<FootTrajBounds> FootTrajBoundsMap;
 
 //////////////////////////////////////////
 // Control Types
-/** @brief map leg name to ground reaction forces [fx, fy, fz] */
-typedef std::map<std::string, vec3> ForceMap;
+/** @brief map leg to ground reaction forces [fx, fy, fz] */
+typedef LegMap<vec3> ForceMap;
 
-/** @brief map leg name to joint toques [hip, thigh, calf] */
-typedef std::map<std::string, vec3> TorqueMap;
+/** @brief map leg to joint toques [hip, thigh, calf] */
+typedef LegMap<vec3> TorqueMap;
 
 //////////////////////////////////////////
 // Joint Types
-/** @brief map leg name to joint angular positions and velocities */
-typedef std::map<std::string, LegJointStates> JointStatesMap;
+/** @brief map leg to joint angular positions and velocities */
+typedef LegMap<LegJointStates> JointStatesMap;
 
 }  // namespace quadruped_controller
 #endif
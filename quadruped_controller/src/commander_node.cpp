@@ -7,7 +7,8 @@
  * @PARAMETERS:
  *
  * @PUBLISHES:
- *    joint_torque_cmd (quadruped_msgs/JointTorqueCmd) - joint torques
+ *    joint_torque_order (quadruped_msgs/JointTorqueOrder) - latched actuator ordering
+ *    joint_torque_stream (quadruped_msgs/JointTorqueStream) - joint torques in the latched order
  * @SUBSCRIBES:
  *    joint_states (sensor_msgs/JointState) - joint names, positions, and velocities
  *    com_state (quadruped_msgs/CoMState) - COM pose and velocity twist in world frame
@@ -17,7 +18,13 @@
  */
 
 // C++
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <map>
+#include <memory>
+#include <thread>
+#include <tuple>
 #include <utility>
 #include <iomanip>
 
@@ -32,14 +39,23 @@
 
 // Quadruped Control
 #include <quadruped_controller/balance_controller.hpp>
+#include <quadruped_controller/mpc_controller.hpp>
 #include <quadruped_controller/gait.hpp>
 #include <quadruped_controller/foot_planner.hpp>
 #include <quadruped_controller/joint_controller.hpp>
 #include <quadruped_controller/kinematics.hpp>
+#include <quadruped_controller/static_kinematics.hpp>
 #include <quadruped_controller/trajectory.hpp>
+#include <quadruped_controller/realtime.hpp>
+#include <quadruped_controller/instrumentation.hpp>
+#include <quadruped_controller/shared_memory_transport.hpp>
+#include <quadruped_controller/telemetry.hpp>
+#include <quadruped_controller/capture.hpp>
 #include <quadruped_controller/math/numerics.hpp>
 #include <quadruped_msgs/CoMState.h>
-#include <quadruped_msgs/JointTorqueCmd.h>
+#include <quadruped_msgs/JointTorqueOrder.h>
+#include <quadruped_msgs/JointTorqueStream.h>
+#include <quadruped_msgs/LoopDiagnostics.h>
 
 using arma::eye;
 using arma::mat;
@@ -51,26 +67,161 @@ using namespace math;
 
 const static std::string LOGNAME = "commander";
 
-static bool joint_states_received = false;
-static bool com_state_received = false;
-static bool stand_cmd_received = false;
-static bool cmd_vel_received = false;
+static std::atomic_bool joint_states_received = false;
+static std::atomic_bool com_state_received = false;
+static std::atomic_bool stand_cmd_received = false;
+static std::atomic_bool cmd_vel_received = false;
 
 // IMPORTANT: Most of the software has been configured to run
 //            with these joint names and in this order
 static std::vector<std::string> leg_names = { "RL", "FL", "RR", "FR" };
 
-// Actual State
-static JointStatesMap joint_states_map;  // q and qdot
+// Pipeline stage indices for latency instrumentation
+enum PipelineStage : unsigned int
+{
+  GAIT_SCHEDULE = 0,
+  FOOTHOLD_PLAN,
+  FOOT_TRAJECTORY,
+  GRF_CONTROL,
+  JACOBIAN_CONTROL,
+  LOOP_CYCLE
+};
+
+static const std::vector<std::string> pipeline_stage_names = {
+  "gait_schedule",  "foothold_plan",    "foot_trajectory",
+  "grf_control",    "jacobian_control", "loop_cycle"
+};
+
+/** @brief Joint states snapshot with all legs zeroed */
+static JointStatesMap zero_joint_states()
+{
+  JointStatesMap joint_states_map;
+  for (const auto& leg_name : leg_names)
+  {
+    joint_states_map.emplace(leg_name, LegJointStates());
+  }
+
+  return joint_states_map;
+}
 
-static mat Rwb = eye(3, 3);           // COM orientation
-static vec3 x(arma::fill::zeros);     // COM position
-static vec3 xdot(arma::fill::zeros);  // COM linear velocity
-static vec3 w(arma::fill::zeros);     // COM angular velocity
+/** @brief CoM state snapshot at the world origin */
+static RobotStateCoM zero_com_state()
+{
+  RobotStateCoM com_state;
+  com_state.x.zeros();
+  com_state.xdot.zeros();
+  com_state.w.zeros();
+  com_state.Rwb.eye();
 
-// Cmd
-// body twist [vy, vy, vz, wx, wy, wz]
-static vec Vb(6, arma::fill::zeros);
+  return com_state;
+}
+
+// Subscriber callbacks run on a spinner thread and publish snapshots
+// into these lock-free buffers; the control thread reads a consistent
+// snapshot at the top of every cycle so message deserialization never
+// blocks control.
+
+// Actual state: q and qdot
+static realtime::StateBuffer<JointStatesMap> joint_states_buffer(zero_joint_states());
+
+// Actual state: COM pose and velocities
+static realtime::StateBuffer<RobotStateCoM> com_state_buffer(zero_com_state());
+
+// Cmd: body twist [vx, vy, vz, wx, wy, wz]
+static realtime::StateBuffer<arma::vec::fixed<6>> cmd_buffer(
+    arma::vec::fixed<6>(arma::fill::zeros));
+
+/** @brief Inputs to one GRF optimization */
+struct GrfProblem
+{
+  mat33 Rwb;              // actual orientation
+  mat33 Rwb_d;            // desired orientation
+  vec3 x;                 // actual position
+  vec3 xdot;              // actual linear velocity
+  vec3 w;                 // actual angular velocity
+  vec3 x_d;               // desired position
+  vec3 xdot_d;            // desired linear velocity
+  vec3 w_d;               // desired angular velocity
+  FootholdMap foot_map;   // feet positions (body frame)
+  GaitMap gait_map;       // gait schedule
+  bool valid = false;     // true once the fast loop publishes a problem
+};
+
+/** @brief Latest completed GRF solution */
+struct GrfSolution
+{
+  ForceMap force_map;          // optimized GRFs (stance legs)
+  GaitMap gait_map;            // gait schedule the solution was computed for
+  unsigned int qp_failures = 0;  // consecutive failed QP solves
+  bool valid = false;          // true once the solver completes a solve
+};
+
+// The fast loop hands problems to, and consumes completed solutions
+// from, the asynchronous GRF solver thread through these buffers.
+static realtime::StateBuffer<GrfProblem> grf_problem_buffer;
+static realtime::StateBuffer<GrfSolution> grf_solution_buffer;
+
+// Input capture for deterministic replay. The callbacks all run on the
+// single spinner thread so the ring sees one writer.
+static std::unique_ptr<capture::InputLogger> input_logger;
+
+/** @brief Shared inputs for one per-leg forward kinematics task */
+struct FkTaskContext
+{
+  const QuadrupedKinematics* kinematics;     // kinematic model
+  const JointStatesMap* joint_states_map;    // actual joint states
+  mat::fixed<3, 4>* foot_positions;          // foot positions out, one column per leg
+};
+
+/** @brief Compose one leg's foot position in the body frame */
+static void forwardKinematicsTask(void* context, unsigned int leg)
+{
+  auto& ctx = *static_cast<FkTaskContext*>(context);
+  const auto& leg_name = leg_names.at(leg);
+
+  ctx.foot_positions->col(leg) =
+      ctx.kinematics->forwardKinematics(leg_name, ctx.joint_states_map->at(leg_name).q);
+}
+
+/** @brief Shared inputs for one per-leg swing reference task */
+struct SwingTaskContext
+{
+  const FootTrajectoryManager* foot_traj_manager;  // planned foot trajectories
+  const GaitMap* gait_map;                         // gait schedule
+  const mat33* Rwb;                                // actual orientation
+  const vec3* x;                                   // actual COM position
+  std::array<LegJointStates, NUM_LEGS>* swing_js;  // reference joint states out
+  std::array<bool, NUM_LEGS>* swing_valid;         // true for swing legs out
+};
+
+/** @brief Swing reference pipeline for one leg: trajectory -> IK -> J^-1 */
+static void swingReferenceTask(void* context, unsigned int leg)
+{
+  auto& ctx = *static_cast<SwingTaskContext*>(context);
+  const auto& leg_name = leg_names.at(leg);
+  const auto& leg_gait = ctx.gait_map->at(leg_name);
+
+  if (leg_gait.first != LegState::swing)
+  {
+    return;
+  }
+
+  FootState foot_state = ctx.foot_traj_manager->referenceState(leg_name, leg_gait.second);
+
+  // Transform foot state into body frame for IK and J^-1
+  foot_state.position = ctx.Rwb->t() * foot_state.position - *ctx.x;
+  foot_state.velocity = ctx.Rwb->t() * foot_state.velocity;
+
+  // Geometry is fixed per robot at build time so IK and the
+  // jacobian inverse inline into the loop (static_kinematics.hpp)
+  const vec3 q =
+      RobotKinematics::legInverseKinematics(leg_id(leg_name), foot_state.position);
+  const vec3 qdot =
+      RobotKinematics::legJacobianInverse(leg_id(leg_name), q) * foot_state.velocity;
+
+  ctx.swing_js->at(leg) = LegJointStates(q, qdot);
+  ctx.swing_valid->at(leg) = true;
+}
 
 visualization_msgs::MarkerArray
 footTrajViz(const FootTrajectoryManager& foot_traj_manager, const std::string& leg_name,
@@ -127,7 +278,7 @@ footTrajViz(const FootTrajectoryManager& foot_traj_manager, const std::string& l
 
 void jointCallback(const sensor_msgs::JointState::ConstPtr& msg)
 {
-  joint_states_received = true;
+  JointStatesMap joint_states_map = zero_joint_states();
 
   // RL
   joint_states_map.at("RL").q(0) = msg->position.at(0);  // RL_hip_joint
@@ -164,33 +315,90 @@ void jointCallback(const sensor_msgs::JointState::ConstPtr& msg)
   joint_states_map.at("FR").qdot(0) = msg->velocity.at(3);
   joint_states_map.at("FR").qdot(1) = msg->velocity.at(7);
   joint_states_map.at("FR").qdot(2) = msg->velocity.at(11);
+
+  joint_states_buffer.write(joint_states_map);
+  joint_states_received = true;
+
+  if (input_logger)
+  {
+    input_logger->log(capture::pack(msg->header.stamp.toNSec(), joint_states_map));
+  }
+}
+
+/** @brief Unpack a shared-memory joint states snapshot */
+JointStatesMap jointStatesFromSnapshot(const shm::JointStateSnapshot& snapshot)
+{
+  JointStatesMap joint_states_map = zero_joint_states();
+
+  // Snapshot follows the joint_states topic order
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
+  {
+    auto& leg = joint_states_map.at(static_cast<LegId>(i));
+
+    leg.q(0) = snapshot.position[i];      // hip
+    leg.q(1) = snapshot.position[i + 4];  // thigh
+    leg.q(2) = snapshot.position[i + 8];  // calf
+
+    leg.qdot(0) = snapshot.velocity[i];
+    leg.qdot(1) = snapshot.velocity[i + 4];
+    leg.qdot(2) = snapshot.velocity[i + 8];
+  }
+
+  return joint_states_map;
+}
+
+/** @brief Unpack a shared-memory CoM state snapshot */
+RobotStateCoM comStateFromSnapshot(const shm::CoMStateSnapshot& snapshot)
+{
+  const Quaternion quat(snapshot.orientation[0], snapshot.orientation[1],
+                        snapshot.orientation[2], snapshot.orientation[3]);
+
+  RobotStateCoM com_state;
+  com_state.Rwb = quat.rotation().matrix();
+
+  com_state.x = { snapshot.position[0], snapshot.position[1], snapshot.position[2] };
+
+  com_state.xdot = { snapshot.linear_velocity[0], snapshot.linear_velocity[1],
+                     snapshot.linear_velocity[2] };
+
+  com_state.w = { snapshot.angular_velocity[0], snapshot.angular_velocity[1],
+                  snapshot.angular_velocity[2] };
+
+  return com_state;
 }
 
 void stateCallback(const quadruped_msgs::CoMState::ConstPtr& msg)
 {
-  com_state_received = true;
+  const Quaternion quat(msg->pose.orientation.w, msg->pose.orientation.x,
+                        msg->pose.orientation.y, msg->pose.orientation.z);
+
+  RobotStateCoM com_state;
+  com_state.Rwb = quat.rotation().matrix();
 
-  Quaternion quat(msg->pose.orientation.w, msg->pose.orientation.x,
-                  msg->pose.orientation.y, msg->pose.orientation.z);
+  com_state.x(0) = msg->pose.position.x;
+  com_state.x(1) = msg->pose.position.y;
+  com_state.x(2) = msg->pose.position.z;
 
-  Rwb = quat.rotation().matrix();
+  com_state.xdot(0) = msg->twist.linear.x;
+  com_state.xdot(1) = msg->twist.linear.y;
+  com_state.xdot(2) = msg->twist.linear.z;
 
-  x(0) = msg->pose.position.x;
-  x(1) = msg->pose.position.y;
-  x(2) = msg->pose.position.z;
+  com_state.w(0) = msg->twist.angular.x;
+  com_state.w(1) = msg->twist.angular.y;
+  com_state.w(2) = msg->twist.angular.z;
 
-  xdot(0) = msg->twist.linear.x;
-  xdot(1) = msg->twist.linear.y;
-  xdot(2) = msg->twist.linear.z;
+  com_state_buffer.write(com_state);
+  com_state_received = true;
 
-  w(0) = msg->twist.angular.x;
-  w(1) = msg->twist.angular.y;
-  w(2) = msg->twist.angular.z;
+  if (input_logger)
+  {
+    input_logger->log(capture::pack(msg->header.stamp.toNSec(), com_state));
+  }
 }
 
 void cmdCallback(const geometry_msgs::Twist::ConstPtr& msg)
 {
-  cmd_vel_received = true;
+  arma::vec::fixed<6> Vb;
 
   Vb(0) = msg->linear.x;
   Vb(1) = msg->linear.y;
@@ -199,6 +407,15 @@ void cmdCallback(const geometry_msgs::Twist::ConstPtr& msg)
   Vb(3) = msg->angular.x;
   Vb(4) = msg->angular.y;
   Vb(5) = msg->angular.z;
+
+  cmd_buffer.write(Vb);
+  cmd_vel_received = true;
+
+  if (input_logger)
+  {
+    // Twist has no header: stamp on arrival
+    input_logger->log(capture::pack(ros::Time::now().toNSec(), Vb));
+  }
 }
 
 bool standConfigCallback(std_srvs::Empty::Request&, std_srvs::Empty::Response&)
@@ -215,12 +432,23 @@ int main(int argc, char** argv)
   ros::NodeHandle nh;
   ros::NodeHandle pnh("~");
 
+  // The actuator ordering is latched once; the per-tick command is only
+  // the fixed torque array in that order
+  ros::Publisher joint_order_pub =
+      nh.advertise<quadruped_msgs::JointTorqueOrder>("joint_torque_order", 1, true);
+
   ros::Publisher joint_cmd_pub =
-      nh.advertise<quadruped_msgs::JointTorqueCmd>("joint_torque_cmd", 1);
+      nh.advertise<quadruped_msgs::JointTorqueStream>("joint_torque_stream", 1);
 
   ros::Publisher foot_traj_position_pub =
       nh.advertise<visualization_msgs::MarkerArray>("foot_trajectory_markers", 1);
 
+  ros::Publisher latency_pub =
+      nh.advertise<quadruped_msgs::LatencyProfile>("latency_profile", 1);
+
+  ros::Publisher diagnostics_pub =
+      nh.advertise<quadruped_msgs::LoopDiagnostics>("loop_diagnostics", 1);
+
   ros::Subscriber joint_sub = nh.subscribe("joint_states", 1, jointCallback);
   ros::Subscriber com_state_sub = nh.subscribe("com_state", 1, stateCallback);
   ros::Subscriber cmd_sub = nh.subscribe("cmd_vel", 1, cmdCallback);
@@ -230,13 +458,125 @@ int main(int argc, char** argv)
   // Broadcast post of robot in world frame
   tf2_ros::TransformBroadcaster tf_broadcaster;
 
-  // Configure initial joint states to zeros
-  for (const auto& leg_name : leg_names)
+  const auto frequency = pnh.param<double>("frequency", 100.0);
+
+  // Real-time executor configuration: callbacks are served on a spinner
+  // thread while this thread runs the control loop.
+  const auto rt_priority = pnh.param<int>("realtime/priority", 0);
+  const auto rt_cpu = pnh.param<int>("realtime/cpu", -1);
+
+  if (rt_priority > 0)
   {
-    joint_states_map.emplace(leg_name, LegJointStates());
+    realtime::lock_memory();
+    realtime::set_thread_priority(rt_priority);
   }
 
-  const auto frequency = pnh.param<double>("frequency", 100.0);
+  if (rt_cpu >= 0)
+  {
+    realtime::set_cpu_affinity(rt_cpu);
+  }
+
+  // Per-leg task pool: persistent spinning workers fan the swing-leg
+  // pipeline and the FK pass across cores, joining before the GRF
+  // solve (0 disables, the loop then runs the tasks inline)
+  const auto task_pool_threads =
+      static_cast<unsigned int>(pnh.param<int>("task_pool/threads", 0));
+
+  std::unique_ptr<realtime::TaskPool> task_pool;
+  if (task_pool_threads > 0)
+  {
+    ROS_INFO_NAMED(LOGNAME, "Fanning per-leg tasks across %u worker threads",
+                   task_pool_threads);
+    task_pool = std::make_unique<realtime::TaskPool>(task_pool_threads);
+  }
+
+  // Latency instrumentation around the pipeline stages. Aggregated
+  // p50/p99/max per stage are published at a low rate.
+  const auto profile_enabled = pnh.param<bool>("instrumentation/enabled", false);
+  const auto profile_period = pnh.param<double>("instrumentation/report_period", 1.0);
+
+  const instrumentation::PipelineProfiler profiler(pipeline_stage_names,
+                                                   profile_enabled);
+
+  // Deadline watchdog around the control loop. Every cycle is measured
+  // against the period budget: an overrun publishes loop_diagnostics the
+  // cycle it happens and a sustained streak latches degraded mode where
+  // the loop skips foothold replanning and reuses the last GRF solution
+  // until it catches up. Stage blame requires instrumentation/enabled.
+  const auto watchdog_enabled = pnh.param<bool>("watchdog/enabled", false);
+  const auto watchdog_budget_scale = pnh.param<double>("watchdog/budget_scale", 1.0);
+  const auto watchdog_degrade_after =
+      static_cast<unsigned int>(pnh.param<int>("watchdog/degrade_after", 3));
+
+  const auto cycle_budget_ns =
+      static_cast<uint64_t>(watchdog_budget_scale * 1.0e9 / frequency);
+  instrumentation::DeadlineMonitor deadline_monitor(cycle_budget_ns,
+                                                    watchdog_degrade_after);
+
+  // Zero-copy shared-memory transport to the simulation interface.
+  // When enabled, state snapshots and torque commands cross process
+  // boundaries as fixed-size POD structs and the ROS topics become an
+  // optional mirror for tooling.
+  const auto use_shm = pnh.param<bool>("shm/enabled", false);
+  const auto mirror_topics = pnh.param<bool>("shm/mirror_topics", true);
+
+  std::unique_ptr<shm::Channel<shm::JointStateSnapshot>> joint_state_channel;
+  std::unique_ptr<shm::Channel<shm::CoMStateSnapshot>> com_state_channel;
+  std::unique_ptr<shm::Channel<shm::JointTorqueSnapshot>> joint_torque_channel;
+
+  if (use_shm)
+  {
+    ROS_INFO_STREAM_NAMED(LOGNAME, "Using shared-memory state transport");
+
+    joint_state_channel =
+        std::make_unique<shm::Channel<shm::JointStateSnapshot>>(shm::JOINT_STATE_CHANNEL);
+    com_state_channel =
+        std::make_unique<shm::Channel<shm::CoMStateSnapshot>>(shm::COM_STATE_CHANNEL);
+    joint_torque_channel = std::make_unique<shm::Channel<shm::JointTorqueSnapshot>>(
+        shm::JOINT_TORQUE_CHANNEL);
+  }
+
+  // Binary telemetry ring buffer. One fixed-schema record per control
+  // tick lands in a memory-mapped file with a single memcpy.
+  const auto telemetry_enabled = pnh.param<bool>("telemetry/enabled", false);
+  const auto telemetry_path =
+      pnh.param<std::string>("telemetry/path", "/tmp/quadruped_telemetry.bin");
+  const auto telemetry_capacity =
+      static_cast<uint32_t>(pnh.param<int>("telemetry/capacity", 30000));
+  const auto telemetry_flush_period = pnh.param<double>("telemetry/flush_period", 0.5);
+
+  std::unique_ptr<telemetry::TelemetryLogger> telemetry_logger;
+  if (telemetry_enabled)
+  {
+    telemetry_logger = std::make_unique<telemetry::TelemetryLogger>(
+        telemetry_path, telemetry_capacity, telemetry_flush_period);
+
+    if (!telemetry_logger->valid())
+    {
+      telemetry_logger.reset();
+    }
+  }
+
+  // Input capture ring buffer. Every joint states, COM state, and
+  // cmd_vel snapshot lands in a memory-mapped file for offline replay
+  // with replay_commander.
+  const auto capture_enabled = pnh.param<bool>("capture/enabled", false);
+  const auto capture_path =
+      pnh.param<std::string>("capture/path", "/tmp/quadruped_capture.bin");
+  const auto capture_capacity =
+      static_cast<uint32_t>(pnh.param<int>("capture/capacity", 600000));
+  const auto capture_flush_period = pnh.param<double>("capture/flush_period", 0.5);
+
+  if (capture_enabled)
+  {
+    input_logger = std::make_unique<capture::InputLogger>(
+        capture_path, capture_capacity, capture_flush_period);
+
+    if (!input_logger->valid())
+    {
+      input_logger.reset();
+    }
+  }
 
   // Body COM frame
   const auto base_link_name = pnh.param<std::string>("links/base_link", "trunk");
@@ -251,6 +591,13 @@ int main(int argc, char** argv)
   pnh.getParam("gait/gait_offset_phases", gait_offset_phases);  // [RL FL RR FR]
   const vec phase_offset(gait_offset_phases);
 
+  // COM reference trajectory shaping
+  const auto linear_accel_max =
+      pnh.param<double>("base_trajectory/linear_accel_max", 2.5);
+  const auto angular_accel_max =
+      pnh.param<double>("base_trajectory/angular_accel_max", 5.0);
+  const auto filter_cutoff = pnh.param<double>("base_trajectory/filter_cutoff", 5.0);
+
   // Robot joint configuration
   const auto num_joints =
       static_cast<unsigned int>(pnh.param<int>("joints/num_joints", 12));
@@ -266,24 +613,13 @@ int main(int argc, char** argv)
                     num_joints, joint_actuator_names.size());
   }
 
-  // map leg name to actuator names
-  std::map<std::string, std::vector<std::string>> actuator_map;
-  actuator_map.emplace(leg_names.at(0),
-                       std::vector<std::string>{ joint_actuator_names.at(0),
-                                                 joint_actuator_names.at(1),
-                                                 joint_actuator_names.at(2) });
-  actuator_map.emplace(leg_names.at(1),
-                       std::vector<std::string>{ joint_actuator_names.at(3),
-                                                 joint_actuator_names.at(4),
-                                                 joint_actuator_names.at(5) });
-  actuator_map.emplace(leg_names.at(2),
-                       std::vector<std::string>{ joint_actuator_names.at(6),
-                                                 joint_actuator_names.at(7),
-                                                 joint_actuator_names.at(8) });
-  actuator_map.emplace(leg_names.at(3),
-                       std::vector<std::string>{ joint_actuator_names.at(9),
-                                                 joint_actuator_names.at(10),
-                                                 joint_actuator_names.at(11) });
+  // Negotiate the actuator ordering once: joint_actuator_names is
+  // already three actuators per leg in the canonical leg order
+  // [RL FL RR FR], so receivers latch this and every per-tick command is
+  // an indexed copy with no names attached
+  quadruped_msgs::JointTorqueOrder torque_order_msg;
+  torque_order_msg.actuator_name = joint_actuator_names;
+  joint_order_pub.publish(torque_order_msg);
 
   // Robot controller
   double w_diagonal = 1e-5;
@@ -337,11 +673,35 @@ int main(int argc, char** argv)
   const BalanceController balance_controller(mu, mass, fzmin, fzmax, Ib, S, W, kff, kp_p,
                                              kd_p, kp_w, kd_w, leg_names);
 
+  // Horizon based GRF control
+  const auto use_mpc = pnh.param<bool>("mpc/enabled", false);
+  const auto mpc_horizon =
+      static_cast<unsigned int>(pnh.param<int>("mpc/horizon", 10));
+  const auto mpc_dt = pnh.param<double>("mpc/dt", 0.03);
+  const auto mpc_r_weight = pnh.param<double>("mpc/r_weight", 1e-5);
+
+  // State error weights [theta, p, w, pdot, g]
+  std::vector<double> mpc_q_weights = { 1.0, 1.0, 10.0, 1.0, 1.0, 50.0, 0.1,
+                                        0.1, 0.1, 1.0,  1.0, 1.0, 0.0 };
+  pnh.getParam("mpc/q_weights", mpc_q_weights);
+
+  const ConvexMPC mpc_controller(mu, mass, fzmin, fzmax, Ib, vec(mpc_q_weights),
+                                 mpc_r_weight, mpc_horizon, mpc_dt, leg_names);
+
+  if (use_mpc)
+  {
+    ROS_INFO_NAMED(LOGNAME, "Using MPC for GRF control with horizon: %u", mpc_horizon);
+  }
+
   // Joint PD control for swing legs
   const JointController joint_controller(jc_kff, jc_kp, jc_kd);
 
-  // User cmd integration step
-  const auto dt = 0.001;
+  // Asynchronous GRF optimization. The fast loop runs gait phase lookup,
+  // swing tracking, and jacobian control at the full loop rate while a
+  // solver thread runs the QP at its own rate; the fast loop always
+  // consumes the latest completed solution and never blocks on a solve.
+  const auto async_grf = pnh.param<bool>("async_grf/enabled", false);
+  const auto grf_frequency = pnh.param<double>("async_grf/frequency", 100.0);
 
   // Hard code the desired COM state to standing configuration
   mat Rwb_d = eye(3, 3);           // base orientation in world
@@ -361,6 +721,11 @@ int main(int argc, char** argv)
                                                 t_stance);  // foot trajectories
   const GaitScheduler gait_scheduler(t_swing, t_stance, phase_offset);  // gait schedule
 
+  // COM reference generator: shapes cmd_vel with acceleration limits
+  // and integrates the desired pose incrementally every control tick
+  BaseTrajectory base_trajectory(1.0 / frequency, linear_accel_max, angular_accel_max,
+                                 filter_cutoff);
+
   x_d = x_stand;
   bool standing = false;
   bool gait_running = false;
@@ -368,10 +733,120 @@ int main(int argc, char** argv)
   // Use stance gait to get robot into standing configuration
   GaitMap gait_map = make_stance_gait();
 
+  // MPC contact lookahead buffers, resized once on first use
+  arma::Mat<unsigned int> contact_horizon;
+  mat phase_horizon;
+
+  // Last synchronous GRF solution, reused while degraded
+  ForceMap grf_fallback_map;
+  bool grf_fallback_valid = false;
+
+  // Reused every tick so the torque publish path never allocates
+  quadruped_msgs::JointTorqueStream torque_stream_msg;
+
+  std::atomic_bool solver_running = true;
+  std::thread grf_solver_thread;
+
+  if (async_grf)
+  {
+    ROS_INFO_NAMED(LOGNAME, "Solving GRFs asynchronously at %.1f Hz", grf_frequency);
+
+    grf_solver_thread = std::thread([&] {
+      // Lookahead buffers owned by the solver thread
+      arma::Mat<unsigned int> solver_contact_horizon;
+      mat solver_phase_horizon;
+
+      ros::Rate solver_rate(grf_frequency);
+      while (solver_running)
+      {
+        const GrfProblem problem = grf_problem_buffer.read();
+        if (problem.valid)
+        {
+          GrfSolution solution;
+          solution.force_map = profiler.measure(GRF_CONTROL, [&] {
+            if (use_mpc)
+            {
+              // Predict the contact sequence over the prediction horizon
+              gait_scheduler.scheduleHorizon(0.0, mpc_dt, mpc_horizon,
+                                             solver_contact_horizon,
+                                             solver_phase_horizon);
+
+              return mpc_controller.control(problem.Rwb, problem.Rwb_d, problem.x,
+                                            problem.xdot, problem.w, problem.x_d,
+                                            problem.xdot_d, problem.w_d,
+                                            problem.foot_map, problem.gait_map,
+                                            solver_contact_horizon);
+            }
+
+            return balance_controller.control(problem.Rwb, problem.Rwb_d, problem.x,
+                                              problem.xdot, problem.w, problem.x_d,
+                                              problem.xdot_d, problem.w_d,
+                                              problem.foot_map, problem.gait_map);
+          });
+
+          solution.gait_map = problem.gait_map;
+          solution.qp_failures = use_mpc ? 0 : balance_controller.consecutiveFailures();
+          solution.valid = true;
+
+          grf_solution_buffer.write(solution);
+        }
+
+        solver_rate.sleep();
+      }
+    });
+  }
+
+  // Serve subscriber callbacks on a separate thread
+  ros::AsyncSpinner spinner(1);
+  spinner.start();
+
   ros::Rate rate(frequency);
+  ros::Time last_latency_report = ros::Time::now();
   while (nh.ok())
   {
-    ros::spinOnce();
+    if (watchdog_enabled)
+    {
+      deadline_monitor.beginCycle();
+      profiler.resetStageDurations();
+    }
+
+    // Shed load while the watchdog has degraded mode latched
+    const bool degraded = watchdog_enabled && deadline_monitor.degraded();
+
+    // Latest consistent state snapshots
+    JointStatesMap joint_states_map = zero_joint_states();
+    RobotStateCoM com_state = zero_com_state();
+
+    if (use_shm)
+    {
+      // Read the simulation interface snapshots directly
+      shm::JointStateSnapshot joint_state_snapshot;
+      if (joint_state_channel->read(joint_state_snapshot))
+      {
+        joint_states_map = jointStatesFromSnapshot(joint_state_snapshot);
+        joint_states_received = true;
+      }
+
+      shm::CoMStateSnapshot com_state_snapshot;
+      if (com_state_channel->read(com_state_snapshot))
+      {
+        com_state = comStateFromSnapshot(com_state_snapshot);
+        com_state_received = true;
+      }
+    }
+
+    else
+    {
+      joint_states_map = joint_states_buffer.read();
+      com_state = com_state_buffer.read();
+    }
+
+    const vec::fixed<6> Vb = cmd_buffer.read();
+
+    const mat33& Rwb = com_state.Rwb;
+    const vec3& x = com_state.x;
+    const vec3& xdot = com_state.xdot;
+    const vec3& w = com_state.w;
 
     // Signaled to stand
     if (stand_cmd_received)
@@ -379,9 +854,27 @@ int main(int argc, char** argv)
       // Robot state is known
       if (joint_states_received && com_state_received)
       {
-        // FK (body frame)
-        const FootholdMap foot_actual_map =
-            kinematics.forwardKinematics(joint_states_map);
+        // FK (body frame), one task per leg
+        mat::fixed<3, 4> fk_positions;
+        FkTaskContext fk_context{ &kinematics, &joint_states_map, &fk_positions };
+
+        if (task_pool)
+        {
+          task_pool->run(forwardKinematicsTask, &fk_context, NUM_LEGS);
+        }
+        else
+        {
+          for (unsigned int i = 0; i < NUM_LEGS; i++)
+          {
+            forwardKinematicsTask(&fk_context, i);
+          }
+        }
+
+        FootholdMap foot_actual_map;
+        for (unsigned int i = 0; i < NUM_LEGS; i++)
+        {
+          foot_actual_map.emplace(leg_names.at(i), vec3(fk_positions.col(i)));
+        }
 
         // Robot is standing
         if (quadruped_controller::math::almost_equal(x(2), x_stand(2), 0.005) && !standing)
@@ -394,47 +887,32 @@ int main(int argc, char** argv)
         {
           if (gait_running)
           {
-            if (cmd_vel_received)
-            {
-              const Pose pose(Rwb, x);
-              const Pose pose_desired = integrate_twist_yaw(pose, Vb, dt);
-
-              // Desired pose
-              Rwb_d = pose_desired.orientation.matrix();
-              x_d = pose_desired.position;
-
-              // TODO: height drifts
-              x_d(2) = x_stand(2);
-
-              // Desired velocities
-              const vec Vw = pose.transform().adjoint() * Vb;
-              xdot_d = Vw.rows(0, 2);
-              w_d = Vw.rows(3, 5);
+            // Shape the latest commanded twist and advance the COM
+            // reference one tick; the height is pinned inside the
+            // trajectory so it cannot drift
+            base_trajectory.advance(Vb);
 
-              // std::cout << "height: " << x(2) << std::endl;
-              // std::cout << "desited height: " << x_d(2) << std::endl;
-
-              // std::cout << "yaw rate actual: " << w(2) << std::endl;
-              // std::cout << "yaw rate desired: " << w_d(2) << std::endl;
-
-              // std::cout << "forward velocity: " << xdot(0) << std::endl;
-              // std::cout << "forward velocity desired: " << xdot_d(0) << std::endl;
-
-              // xdot_d.print("Desired xdot:");
-              // xdot.print("Actual xdot:");
-
-              cmd_vel_received = false;
-            }
+            Rwb_d = base_trajectory.rotation();
+            x_d = base_trajectory.position();
+            xdot_d = base_trajectory.linearVelocity();
+            w_d = base_trajectory.angularVelocity();
 
             // Foot reference states (world frame)
             FootStateMap foot_states_map;
 
             // Gait schedule
-            gait_map = gait_scheduler.schedule();
-
-            // Plan footholds (world frame)
-            const auto foothold_plan = foothold_planner.positions(
-                t_stance, Rwb, x, xdot, w, xdot_d, foot_actual_map, gait_map);
+            gait_map =
+                profiler.measure(GAIT_SCHEDULE, [&] { return gait_scheduler.schedule(); });
+
+            // Plan footholds (world frame); degraded mode skips
+            // replanning and tracks the trajectories already in flight
+            const auto foothold_plan =
+                degraded ? std::tuple<bool, FootholdMap>(false, FootholdMap()) :
+                           profiler.measure(FOOTHOLD_PLAN, [&] {
+                             return foothold_planner.positions(t_stance, Rwb, x, xdot, w,
+                                                               xdot_d, foot_actual_map,
+                                                               gait_map);
+                           });
 
             const bool new_footholds = std::get<bool>(foothold_plan);
             const FootholdMap foothold_final_map = std::get<FootholdMap>(foothold_plan);
@@ -442,7 +920,8 @@ int main(int argc, char** argv)
             if (!new_footholds)
             {
               // No planning just update reference foot states
-              foot_states_map = foot_traj_manager.referenceStates(gait_map);
+              foot_states_map = profiler.measure(
+                  FOOT_TRAJECTORY, [&] { return foot_traj_manager.referenceStates(gait_map); });
             }
 
             else
@@ -457,8 +936,9 @@ int main(int argc, char** argv)
               }
 
               // Plan foot trajectories (world frame) and get reference states
-              foot_states_map =
-                  foot_traj_manager.referenceStates(gait_map, foot_traj_bounds_map);
+              foot_states_map = profiler.measure(FOOT_TRAJECTORY, [&] {
+                return foot_traj_manager.referenceStates(gait_map, foot_traj_bounds_map);
+              });
 
               // Visualize foot trajectories for swing legs
               for (const auto& leg : foothold_final_map)
@@ -474,28 +954,40 @@ int main(int argc, char** argv)
           else
           {
             gait_scheduler.start();
+
+            // Start the reference from the actual pose at gait onset
+            base_trajectory.reset(x, Quaternion(Rwb).eulerAngles()(2), x_stand(2));
             gait_running = true;
           }
         }
 
-        // Leg swing reference joint states
-        JointStatesMap swing_leg_js_map;
-        for (const auto& [leg_name, leg_state] : gait_map)
-        {
-          if (leg_state.first == LegState::swing)
-          {
-            FootState foot_state =
-                foot_traj_manager.referenceState(leg_name, gait_map.at(leg_name).second);
+        // Leg swing reference joint states: the per-leg trajectory
+        // tracking, IK, and jacobian inverse are independent so they
+        // fan across the task pool, joining before the GRF solve
+        std::array<LegJointStates, NUM_LEGS> swing_js;
+        std::array<bool, NUM_LEGS> swing_valid = { false, false, false, false };
 
-            // Transform foot state into body frame for IK and J^-1
-            foot_state.position = Rwb.t() * foot_state.position - x;
-            foot_state.velocity = Rwb.t() * foot_state.velocity;
+        SwingTaskContext swing_context{ &foot_traj_manager, &gait_map, &Rwb,
+                                        &x,                 &swing_js, &swing_valid };
 
-            const vec3 q = kinematics.legInverseKinematics(leg_name, foot_state.position);
-            const vec3 qdot =
-                kinematics.legJacobianInverse(leg_name, q) * foot_state.velocity;
+        if (task_pool)
+        {
+          task_pool->run(swingReferenceTask, &swing_context, NUM_LEGS);
+        }
+        else
+        {
+          for (unsigned int i = 0; i < NUM_LEGS; i++)
+          {
+            swingReferenceTask(&swing_context, i);
+          }
+        }
 
-            swing_leg_js_map.emplace(leg_name, LegJointStates(q, qdot));
+        JointStatesMap swing_leg_js_map;
+        for (unsigned int i = 0; i < NUM_LEGS; i++)
+        {
+          if (swing_valid.at(i))
+          {
+            swing_leg_js_map.emplace(leg_names.at(i), swing_js.at(i));
           }
         }
 
@@ -504,33 +996,210 @@ int main(int argc, char** argv)
             joint_controller.control(swing_leg_js_map, joint_states_map);
 
         // Optimize GRF for stance legs
-        const ForceMap force_map = balance_controller.control(
-            Rwb, Rwb_d, x, xdot, w, x_d, xdot_d, w_d, foot_actual_map, gait_map);
+        ForceMap force_map;
+        unsigned int qp_failures = 0;
+
+        if (async_grf)
+        {
+          // Hand the latest state to the solver thread and consume the
+          // most recent completed solution without blocking
+          GrfProblem problem;
+          problem.Rwb = Rwb;
+          problem.Rwb_d = Rwb_d;
+          problem.x = x;
+          problem.xdot = xdot;
+          problem.w = w;
+          problem.x_d = x_d;
+          problem.xdot_d = xdot_d;
+          problem.w_d = w_d;
+          problem.foot_map = foot_actual_map;
+          problem.gait_map = gait_map;
+          problem.valid = true;
+
+          grf_problem_buffer.write(problem);
+
+          const GrfSolution solution = grf_solution_buffer.read();
+          if (solution.valid)
+          {
+            // Drop solution legs that entered swing since the solve
+            for (const auto& [leg_name, force] : solution.force_map)
+            {
+              if (gait_map.at(leg_name).first == LegState::stance)
+              {
+                force_map.emplace(leg_name, force);
+              }
+            }
+
+            qp_failures = solution.qp_failures;
+          }
+        }
+
+        else if (degraded && grf_fallback_valid)
+        {
+          // Reuse the last GRF solution while over budget; legs that
+          // entered swing since it was computed are dropped
+          for (const auto& [leg_name, force] : grf_fallback_map)
+          {
+            if (gait_map.at(leg_name).first == LegState::stance)
+            {
+              force_map.emplace(leg_name, force);
+            }
+          }
+        }
+
+        else
+        {
+          force_map = profiler.measure(GRF_CONTROL, [&] {
+            if (use_mpc)
+            {
+              // Predict the contact sequence over the prediction horizon
+              gait_scheduler.scheduleHorizon(0.0, mpc_dt, mpc_horizon, contact_horizon,
+                                             phase_horizon);
+
+              return mpc_controller.control(Rwb, Rwb_d, x, xdot, w, x_d, xdot_d, w_d,
+                                            foot_actual_map, gait_map, contact_horizon);
+            }
 
-        // Only use for stance legs
-        TorqueMap torque_map =
-            kinematics.jacobianTransposeControl(joint_states_map, force_map);
+            return balance_controller.control(Rwb, Rwb_d, x, xdot, w, x_d, xdot_d, w_d,
+                                              foot_actual_map, gait_map);
+          });
 
-        // Merge torque maps
-        torque_map.insert(swing_torque_map.begin(), swing_torque_map.end());
+          qp_failures = use_mpc ? 0 : balance_controller.consecutiveFailures();
+
+          if (watchdog_enabled)
+          {
+            grf_fallback_map = force_map;
+            grf_fallback_valid = true;
+          }
+        }
+
+        // Merge the stance and swing torques by contact mask in one
+        // batched pass: J^T f for legs with a GRF, swing PD otherwise
+        mat::fixed<3, 4> qs;
+        mat::fixed<3, 4> f_stance(arma::fill::zeros);
+        mat::fixed<3, 4> tau_swing(arma::fill::zeros);
+        std::array<bool, NUM_LEGS> stance_mask = { false, false, false, false };
+        std::array<bool, NUM_LEGS> torque_valid = { false, false, false, false };
+
+        for (unsigned int i = 0; i < NUM_LEGS; i++)
+        {
+          qs.col(i) = joint_states_map.at(static_cast<LegId>(i)).q;
+        }
+
+        for (const auto& [leg_name, force] : force_map)
+        {
+          const auto id = leg_id(leg_name);
+          f_stance.col(id) = force;
+          stance_mask.at(id) = true;
+          torque_valid.at(id) = true;
+        }
+
+        for (const auto& [leg_name, leg_torque] : swing_torque_map)
+        {
+          const auto id = leg_id(leg_name);
+          tau_swing.col(id) = leg_torque;
+          torque_valid.at(id) = true;
+        }
+
+        vec::fixed<12> tau_cmd;
+        profiler.measure(JACOBIAN_CONTROL, [&] {
+          kinematics.jacobianTransposeControl(qs, f_stance, tau_swing, stance_mask,
+                                              tau_cmd);
+        });
+
+        // Torque limits
+        tau_cmd = arma::clamp(tau_cmd, tau_min, tau_max);
+
+        if (telemetry_logger)
+        {
+          // Per leg signals follow the canonical order [RL FL RR FR]
+          telemetry::TelemetryRecord record{};
+          record.stamp_ns =
+              static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch() /
+                                    std::chrono::nanoseconds(1));
+
+          const Quaternion quat_wb(Rwb);
+          record.orientation[0] = quat_wb.w();
+          record.orientation[1] = quat_wb.x();
+          record.orientation[2] = quat_wb.y();
+          record.orientation[3] = quat_wb.z();
+
+          for (unsigned int i = 0; i < 3; i++)
+          {
+            record.position[i] = x(i);
+            record.linear_velocity[i] = xdot(i);
+            record.angular_velocity[i] = w(i);
+
+            record.position_desired[i] = x_d(i);
+            record.linear_velocity_desired[i] = xdot_d(i);
+            record.angular_velocity_desired[i] = w_d(i);
+          }
+
+          // Swing legs are absent from the force map and stay zero
+          for (const auto& [leg_name, force] : force_map)
+          {
+            const auto offset = static_cast<unsigned int>(leg_id(leg_name)) * 3;
+            record.grf[offset] = force(0);
+            record.grf[offset + 1] = force(1);
+            record.grf[offset + 2] = force(2);
+          }
+
+          // Legs without a stance or swing torque stay zero
+          for (unsigned int i = 0; i < 12; i++)
+          {
+            record.torque[i] = tau_cmd(i);
+          }
+
+          for (const auto& [leg_name, leg_state] : gait_map)
+          {
+            const auto leg = static_cast<unsigned int>(leg_id(leg_name));
+            record.gait_phase[leg] = leg_state.second;
+            record.leg_state[leg] = (leg_state.first == LegState::swing) ? 1 : 0;
+          }
+
+          record.qp_failures = qp_failures;
+
+          telemetry_logger->log(record);
+        }
 
         // control signal
-        quadruped_msgs::JointTorqueCmd joint_cmd;
-        for (const auto& [leg_name, torque] : torque_map)
+        if (use_shm)
         {
-          joint_cmd.actuator_name.insert(joint_cmd.actuator_name.end(),
-                                         actuator_map.at(leg_name).begin(),
-                                         actuator_map.at(leg_name).end());
+          // Torques follow the canonical actuator order [RL FL RR FR] (hip,thigh,calf)
+          shm::JointTorqueSnapshot torque_snapshot{};
+          torque_snapshot.stamp_ns =
+              static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch() /
+                                    std::chrono::nanoseconds(1));
 
-          // Torque limits
-          const vec3 tau = arma::clamp(torque, tau_min, tau_max);
-          const std::vector<double> tau_vec =
-              arma::conv_to<std::vector<double>>::from(tau);
+          for (unsigned int i = 0; i < 12; i++)
+          {
+            torque_snapshot.torque[i] = tau_cmd(i);
+          }
 
-          joint_cmd.torque.insert(joint_cmd.torque.end(), tau_vec.begin(), tau_vec.end());
+          joint_torque_channel->write(torque_snapshot);
         }
 
-        joint_cmd_pub.publish(joint_cmd);
+        if (!use_shm || mirror_topics)
+        {
+          // Stream the fixed torque array in the latched actuator order.
+          // Keep the previous behavior: legs with neither a GRF nor a
+          // swing torque are masked out and the receiver holds their
+          // last torque
+          torque_stream_msg.leg_mask = 0;
+          for (unsigned int i = 0; i < NUM_LEGS; i++)
+          {
+            if (torque_valid.at(i))
+            {
+              torque_stream_msg.leg_mask |= (1u << i);
+            }
+
+            torque_stream_msg.torque[i * 3] = tau_cmd(i * 3);
+            torque_stream_msg.torque[i * 3 + 1] = tau_cmd(i * 3 + 1);
+            torque_stream_msg.torque[i * 3 + 2] = tau_cmd(i * 3 + 2);
+          }
+
+          joint_cmd_pub.publish(torque_stream_msg);
+        }
       }
     }
 
@@ -554,9 +1223,73 @@ int main(int argc, char** argv)
       tf_broadcaster.sendTransform(T_world_base);
     }
 
+    // Export aggregated stage latencies at a low rate
+    if (profiler.enabled() &&
+        (ros::Time::now() - last_latency_report).toSec() > profile_period)
+    {
+      latency_pub.publish(profiler.report());
+      last_latency_report = ros::Time::now();
+    }
+
+    // Deadline accounting: an overrun surfaces the cycle it happens
+    if (watchdog_enabled)
+    {
+      const auto cycle_report = deadline_monitor.endCycle();
+      const auto [worst_stage, worst_stage_ns] = profiler.slowestStage();
+
+      if (cycle_report.overrun || cycle_report.degraded_changed)
+      {
+        quadruped_msgs::LoopDiagnostics diag_msg;
+        diag_msg.header.stamp = ros::Time::now();
+        diag_msg.budget_ns = cycle_budget_ns;
+        diag_msg.cycle_ns = cycle_report.duration_ns;
+        diag_msg.overrun = cycle_report.overrun;
+        diag_msg.degraded = cycle_report.degraded;
+        diag_msg.overruns = cycle_report.overruns;
+        diag_msg.consecutive_overruns = cycle_report.consecutive_overruns;
+        diag_msg.worst_stage =
+            profiler.enabled() ? pipeline_stage_names.at(worst_stage) : "";
+        diag_msg.worst_stage_ns = worst_stage_ns;
+
+        diagnostics_pub.publish(diag_msg);
+      }
+
+      if (cycle_report.overrun)
+      {
+        ROS_WARN_THROTTLE_NAMED(1.0, LOGNAME,
+                                "Control cycle overran budget: %.3f ms > %.3f ms "
+                                "(%lu total)",
+                                cycle_report.duration_ns * 1.0e-6,
+                                cycle_budget_ns * 1.0e-6, cycle_report.overruns);
+      }
+
+      if (cycle_report.degraded_changed)
+      {
+        if (cycle_report.degraded)
+        {
+          ROS_WARN_NAMED(LOGNAME, "Entering degraded mode after %u consecutive overruns",
+                         cycle_report.consecutive_overruns);
+        }
+        else
+        {
+          ROS_INFO_STREAM_NAMED(LOGNAME, "Leaving degraded mode");
+        }
+      }
+
+      // Cycle times land in the latency profile alongside the stages
+      profiler.record(LOOP_CYCLE, cycle_report.duration_ns);
+    }
+
     rate.sleep();
   }
 
+  if (async_grf)
+  {
+    solver_running = false;
+    grf_solver_thread.join();
+  }
+
+  spinner.stop();
   ros::shutdown();
   return 0;
 }
@@ -5,6 +5,9 @@
  * @brief Force balance controller
  */
 
+// C++
+#include <cstring>
+
 #include <ros/console.h>
 #include <quadruped_controller/balance_controller.hpp>
 
@@ -21,32 +24,28 @@ static const std::string LOGNAME = "Balance Controller";
 
 void copy_to_real_t(const vec& source, real_t* target)
 {
-  for (unsigned int i = 0; i < source.size(); i++)
-  {
-    target[i] = source(i);
-  }
+  std::memcpy(target, source.memptr(), source.n_elem * sizeof(real_t));
 }
 
 void copy_to_real_t(const mat& source, real_t* target)
 {
-  unsigned int count = 0;
-  for (unsigned int i = 0; i < source.n_rows; i++)
-  {
-    for (unsigned int j = 0; j < source.n_cols; j++)
-    {
-      target[count] = source(i, j);
-      count++;
-    }
-  }
+  // The transpose is column-major contiguous in the row-major order
+  // qpOASES expects, so the conversion is one vectorized transpose plus
+  // a bulk copy instead of a strided scalar loop
+  const mat transposed = source.t();
+  std::memcpy(target, transposed.memptr(), transposed.n_elem * sizeof(real_t));
+}
+
+void copy_to_real_t_symmetric(const mat& source, real_t* target)
+{
+  // Row-major and column-major layouts coincide for symmetric matrices
+  std::memcpy(target, source.memptr(), source.n_elem * sizeof(real_t));
 }
 
 vec copy_from_real_t(const real_t* const source, unsigned int n_rows)
 {
   vec target(n_rows);
-  for (unsigned int i = 0; i < n_rows; i++)
-  {
-    target(i) = source[i];
-  }
+  std::memcpy(target.memptr(), source, n_rows * sizeof(real_t));
 
   return target;
 }
@@ -81,18 +80,16 @@ BalanceController::BalanceController(double mu, double mass, double fzmin, doubl
   , kd_p_(kd_p)
   , kp_w_(kp_w)
   , kd_w_(kd_w)
-  , QPSolver_(num_variables_qp_, num_constraints_qp_)
-  , nWSR_(200)
   , fzmin_(fzmin)
   , fzmax_(fzmax)
   , S_(S)
   , W_(W)
   , C_(frictionConeConstraint())
-  , cpu_time_(0.01)  // run QP at 100 Hz
   , leg_names_(leg_names)
 {
-  // Disable printing
-  QPSolver_.setPrintLevel(qpOASES::PL_NONE);
+  // The constraint matrix never changes: hand it to the backend once so
+  // it is not re-copied every solve
+  qp_solver_.setConstraintMatrix(C_);
 }
 
 ForceMap BalanceController::control(const mat& Rwb, const mat& Rwb_d, const vec& x,
@@ -101,29 +98,34 @@ ForceMap BalanceController::control(const mat& Rwb, const mat& Rwb_d, const vec&
                                     const FootholdMap& foot_map,
                                     const GaitMap& gait_map) const
 {
-  // TODO: return previouse solution if there is a failure
-
   ForceMap force_map;
-  mat ft_p(3, 4, arma::fill::zeros);
+  control(Rwb, Rwb_d, x, xdot, w, x_d, xdot_d, w_d, foot_map, gait_map, force_map);
+  return force_map;
+}
+
+void BalanceController::control(const mat& Rwb, const mat& Rwb_d, const vec& x,
+                                const vec& xdot, const vec& w, const vec& x_d,
+                                const vec& xdot_d, const vec& w_d,
+                                const FootholdMap& foot_map, const GaitMap& gait_map,
+                                ForceMap& force_map) const
+{
+  force_map.clear();
+  mat::fixed<3, 4> ft_p;
 
   for (unsigned int i = 0; i < leg_names_.size(); i++)
   {
-    // Inialize return value to zeros if failure
-    // force_map.emplace(leg_names_.at(i), vec3(arma::fill::zeros));
-
     // Populate foot positions
     ft_p.col(i) = foot_map.at(leg_names_.at(i));
   }
 
   // compose friction cone constraint bounds
-  frictionConeBounds(gait_map);
-
-  // IMPORTANT: Ground reaction forces from QP solver are in world frame
-  vec fw(num_variables_qp_, arma::fill::zeros);
+  vec::fixed<num_constraints_qp_> lbC;
+  vec::fixed<num_constraints_qp_> ubC;
+  frictionConeBounds(gait_map, lbC, ubC);
 
   // PD control on COM position and orientation
   // [R1] Eq(3)
-  vec xddot_d = kp_p_ % (x_d - x) + kd_p_ % (xdot_d - xdot);
+  vec3 xddot_d = kp_p_ % (x_d - x) + kd_p_ % (xdot_d - xdot);
   xddot_d(0) += kff_(0) * xdot_d(0);
   xddot_d(1) += kff_(1) * xdot_d(1);
   xddot_d(2) += kff_(2) * mass_ * 9.81;
@@ -133,7 +135,7 @@ ForceMap BalanceController::control(const mat& Rwb, const mat& Rwb_d, const vec&
   const Rotation3d R_error(Rwb_d * Rwb.t());
 
   // TODO: verify that angleAxisTotal() should be used here
-  vec wdot_d = kp_w_ % R_error.angleAxisTotal() + kd_w_ % (w_d - w);
+  vec3 wdot_d = kp_w_ % R_error.angleAxisTotal() + kd_w_ % (w_d - w);
   wdot_d(0) += kff_(3) * w_d(0);
   wdot_d(1) += kff_(4) * w_d(1);
   wdot_d(1) += kff_(5) * w_d(2);
@@ -141,81 +143,66 @@ ForceMap BalanceController::control(const mat& Rwb, const mat& Rwb_d, const vec&
   // wdot_d.print("wdot_d");
 
   // [R1] Eq(5) Linear Newton-Euler single rigid body dynamics
-  const auto srb_dyn = dynamics(ft_p, Rwb, x, xddot_d, w_d, wdot_d);
-  const mat A_dyn = std::get<mat>(srb_dyn);
-  const vec b_dyn = std::get<vec>(srb_dyn);
+  mat::fixed<num_equations_qp_, num_variables_qp_> A_dyn;
+  vec::fixed<num_equations_qp_> b_dyn;
+  dynamics(ft_p, Rwb, x, xddot_d, w_d, wdot_d, A_dyn, b_dyn);
 
   // TODO: Add regularization term Eq(6)
   // [R1] Convert Eq(6) to QP standard form 1/2*x.T*Q*x + x.T*c
   // Q = 2*(A.T*S*A + W) (12x12)
   // c = -2*A.T*S*b (12x1)
-  const mat Q = 2.0 * (A_dyn.t() * S_ * A_dyn + W_);
-  const vec c = -2.0 * A_dyn.t() * S_ * b_dyn;
-
-  if (!Q.is_sympd())
+  // Staged so intermediates stay fixed-size stack storage.
+  const mat::fixed<num_equations_qp_, num_variables_qp_> SA = S_ * A_dyn;
+  const mat::fixed<num_variables_qp_, num_variables_qp_> Q = 2.0 * (A_dyn.t() * SA + W_);
+  const vec::fixed<num_variables_qp_> c = -2.0 * (SA.t() * b_dyn);
+
+  // Q = 2*(A.T*S*A + W) is symmetric positive definite by construction
+  // (S and W are positive-definite weights); the solver return status
+  // covers numerical degeneracy without a per-tick factorization here.
+
+  // Trivially feasible fallback start: stance legs carry a mid-range
+  // normal force straight down, swing legs are pinned at zero.
+  vec::fixed<num_variables_qp_> x0(arma::fill::zeros);
+  for (unsigned int i = 0; i < leg_names_.size(); i++)
   {
-    ROS_ERROR_STREAM_NAMED(LOGNAME, "Q is NOT semipositive definite");
+    if (gait_map.at(leg_names_.at(i)).first == LegState::stance)
+    {
+      x0(i * 3 + 2) = 0.5 * (fzmin_ + fzmax_);
+    }
   }
 
-  copy_to_real_t(Q, qp_Q_);
-  copy_to_real_t(c, qp_c_);
-
-  // No lower/upper bound constraints on GRFs because
-  // the constraint matrix, C, takes care of this.
-  real_t* qp_lb = nullptr;
-  real_t* qp_ub = nullptr;
-
-  // Primal solution
-  real_t qp_xOpt[num_variables_qp_];
-
-  // Will update based on actual
-  int nWSR_acutal = nWSR_;
-  real_t cpu_time_actual = cpu_time_;
+  // IMPORTANT: Ground reaction forces from QP solver are in world frame
+  vec::fixed<num_variables_qp_> fw;
+  const auto solved = qp_solver_.solve(Q, c, C_, lbC, ubC, x0, solution_cached_, fw);
 
-  // TODO: See Init Homotopy pg 31
-  // TODO: Add initial guess to hotstart
-  if (!QPSolver_.isInitialised())
+  if (solved)
   {
-    const returnValue ret_val = QPSolver_.init(qp_Q_, qp_c_, qp_C_, qp_lb, qp_ub, qp_lbC_,
-                                               qp_ubC_, nWSR_acutal, &cpu_time_actual);
-
-    if (ret_val != qpOASES::SUCCESSFUL_RETURN)
-    {
-      ROS_ERROR_STREAM_NAMED(LOGNAME,
-                             "Failed to initialize Balance Controller QP Solver");
-
-      return force_map;
-    }
+    x_prev_ = fw;
+    solution_cached_ = true;
+    consecutive_failures_ = 0;
   }
 
   else
   {
-    const returnValue ret_val =
-        QPSolver_.hotstart(qp_Q_, qp_c_, qp_C_, qp_lb, qp_ub, qp_lbC_, qp_ubC_,
-                           nWSR_acutal, &cpu_time_actual);
+    consecutive_failures_++;
 
-    if (ret_val != qpOASES::SUCCESSFUL_RETURN)
+    if (!solution_cached_)
     {
-      ROS_ERROR_STREAM_NAMED(LOGNAME, "Failed to hotstart Balance Controller QP Solver");
-      return force_map;
+      ROS_ERROR_STREAM_NAMED(LOGNAME, "Balance Controller QP Solver Failed");
+      return;
     }
-  }
 
-  // std::cout << "CPU time: " << cpu_time_actual << " (s)" << std::endl;
+    // Fall back on the last feasible solution; legs that entered swing
+    // since it was cached are masked out by the stance check below.
+    ROS_WARN_NAMED(LOGNAME,
+                   "Balance Controller QP Solver failed %u consecutive times - "
+                   "returning last feasible solution",
+                   consecutive_failures_);
 
-  if (QPSolver_.isSolved())
-  {
-    QPSolver_.getPrimalSolution(qp_xOpt);
-    fw = copy_from_real_t(qp_xOpt, num_variables_qp_);
-  }
-
-  else
-  {
-    ROS_ERROR_STREAM_NAMED(LOGNAME, "Balance Controller QP Solver Failed");
-    return force_map;
+    fw = x_prev_;
   }
 
-  const mat Rbw = Rwb.t();
+  const mat33 Rbw = Rwb.t();
   unsigned int row = 0;
   unsigned int col = 2;
   for (const auto& leg_name : leg_names_)
@@ -230,27 +217,30 @@ ForceMap BalanceController::control(const mat& Rwb, const mat& Rwb_d, const vec&
     row += 3;
     col += 3;
   }
+}
 
-  return force_map;
+unsigned int BalanceController::consecutiveFailures() const
+{
+  return consecutive_failures_;
 }
 
-tuple<mat, vec> BalanceController::dynamics(const mat& ft_p, const mat& Rwb, const vec& x,
-                                            const vec& xddot_d, const vec& w_d,
-                                            const vec& wdot_d) const
+void BalanceController::dynamics(const mat& ft_p, const mat& Rwb, const vec& x,
+                                 const vec& xddot_d, const vec& w_d, const vec& wdot_d,
+                                 mat::fixed<6, 12>& A, vec::fixed<6>& b) const
 {
   // TODO: verify this is correct the feet are already in the body frame
   // Vector from COM to each foot position in world frame
   // pcom,i = ft_p - x_com = (Rwb * ft_p + x_com) - x_com = Rwb * ft_p
-  mat com_ft_p(3, 4);
+  mat::fixed<3, 4> com_ft_p;
   com_ft_p.col(0) = Rwb * ft_p.col(0);
   com_ft_p.col(1) = Rwb * ft_p.col(1);
   com_ft_p.col(2) = Rwb * ft_p.col(2);
   com_ft_p.col(3) = Rwb * ft_p.col(3);
 
   // Moment of Interia in world frame
-  const mat Iw = Rwb * Ib_ * Rwb.t();
+  const mat33 Iw = Rwb * Ib_ * Rwb.t();
 
-  mat A(num_equations_qp_, num_variables_qp_, arma::fill::zeros);
+  A.zeros();
   A.submat(0, 0, 2, 2) = eye(3, 3);
   A.submat(0, 3, 2, 5) = eye(3, 3);
   A.submat(0, 6, 2, 8) = eye(3, 3);
@@ -261,14 +251,12 @@ tuple<mat, vec> BalanceController::dynamics(const mat& ft_p, const mat& Rwb, con
   A.submat(3, 6, 5, 8) = skew_symmetric(com_ft_p.col(2));
   A.submat(3, 9, 5, 11) = skew_symmetric(com_ft_p.col(3));
 
-  vec b(num_equations_qp_, arma::fill::zeros);
+  b.zeros();
   b.rows(0, 2) = mass_ * (xddot_d + g_);
 
   // TODO: verify convexity of cost function
   // Add cross product term
   b.rows(3, 5) = Iw * wdot_d + arma::cross(w_d, Iw * w_d);
-
-  return std::make_tuple(A, b);
 }
 
 mat BalanceController::frictionConeConstraint() const
@@ -291,18 +279,16 @@ mat BalanceController::frictionConeConstraint() const
   return C;
 }
 
-void BalanceController::frictionConeBounds(const GaitMap& gait_map) const
+void BalanceController::frictionConeBounds(const GaitMap& gait_map,
+                                           vec::fixed<20>& lbC,
+                                           vec::fixed<20>& ubC) const
 {
   const auto upper = 1000000.0;
   const auto lower = -1000000.0;
 
   // Friction cone lower and upper limits per foot
-  const vec lbf = { lower, lower, 0.0, 0.0, fzmin_ };
-  const vec ubf = { 0.0, 0.0, upper, upper, fzmax_ };
-
-  // Lower and upper bounds on constraint matrix
-  vec lbC(num_constraints_qp_);
-  vec ubC(num_constraints_qp_);
+  const vec::fixed<5> lbf = { lower, lower, 0.0, 0.0, fzmin_ };
+  const vec::fixed<5> ubf = { 0.0, 0.0, upper, upper, fzmax_ };
 
   unsigned int row_start = 0;
   unsigned int row_end = 4;
@@ -323,9 +309,5 @@ void BalanceController::frictionConeBounds(const GaitMap& gait_map) const
     row_start += 5;
     row_end += 5;
   }
-
-  copy_to_real_t(C_, qp_C_);
-  copy_to_real_t(lbC, qp_lbC_);
-  copy_to_real_t(ubC, qp_ubC_);
 }
 }  // namespace quadruped_controller
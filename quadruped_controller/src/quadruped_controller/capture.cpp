@@ -0,0 +1,263 @@
+/**
+ * @file capture.cpp
+ * @date 2021-11-27
+ * @author Boston Cleek
+ * @brief Memory-mapped input capture for deterministic replay
+ */
+
+// C++
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+
+// Linux
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ROS
+#include <ros/console.h>
+
+#include <quadruped_controller/capture.hpp>
+
+namespace quadruped_controller
+{
+namespace capture
+{
+static const std::string LOGNAME = "capture";
+
+InputRecord pack(uint64_t stamp_ns, const JointStatesMap& joint_states_map)
+{
+  InputRecord record = {};
+  record.stamp_ns = stamp_ns;
+  record.type = joint_states;
+
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
+  {
+    const LegJointStates& leg = joint_states_map.at(static_cast<LegId>(i));
+
+    record.data[i * 3] = leg.q(0);
+    record.data[i * 3 + 1] = leg.q(1);
+    record.data[i * 3 + 2] = leg.q(2);
+
+    record.data[12 + i * 3] = leg.qdot(0);
+    record.data[12 + i * 3 + 1] = leg.qdot(1);
+    record.data[12 + i * 3 + 2] = leg.qdot(2);
+  }
+
+  return record;
+}
+
+InputRecord pack(uint64_t stamp_ns, const RobotStateCoM& com_state)
+{
+  InputRecord record = {};
+  record.stamp_ns = stamp_ns;
+  record.type = capture::com_state;
+
+  std::memcpy(record.data, com_state.Rwb.memptr(), 9 * sizeof(double));
+  std::memcpy(record.data + 9, com_state.x.memptr(), 3 * sizeof(double));
+  std::memcpy(record.data + 12, com_state.xdot.memptr(), 3 * sizeof(double));
+  std::memcpy(record.data + 15, com_state.w.memptr(), 3 * sizeof(double));
+
+  return record;
+}
+
+InputRecord pack(uint64_t stamp_ns, const arma::vec::fixed<6>& Vb)
+{
+  InputRecord record = {};
+  record.stamp_ns = stamp_ns;
+  record.type = cmd_vel;
+
+  std::memcpy(record.data, Vb.memptr(), 6 * sizeof(double));
+
+  return record;
+}
+
+JointStatesMap unpackJointStates(const InputRecord& record)
+{
+  JointStatesMap joint_states_map;
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
+  {
+    LegJointStates leg;
+
+    leg.q(0) = record.data[i * 3];
+    leg.q(1) = record.data[i * 3 + 1];
+    leg.q(2) = record.data[i * 3 + 2];
+
+    leg.qdot(0) = record.data[12 + i * 3];
+    leg.qdot(1) = record.data[12 + i * 3 + 1];
+    leg.qdot(2) = record.data[12 + i * 3 + 2];
+
+    joint_states_map.emplace(static_cast<LegId>(i), leg);
+  }
+
+  return joint_states_map;
+}
+
+RobotStateCoM unpackComState(const InputRecord& record)
+{
+  RobotStateCoM com_state;
+
+  std::memcpy(com_state.Rwb.memptr(), record.data, 9 * sizeof(double));
+  std::memcpy(com_state.x.memptr(), record.data + 9, 3 * sizeof(double));
+  std::memcpy(com_state.xdot.memptr(), record.data + 12, 3 * sizeof(double));
+  std::memcpy(com_state.w.memptr(), record.data + 15, 3 * sizeof(double));
+
+  return com_state;
+}
+
+arma::vec::fixed<6> unpackCmdVel(const InputRecord& record)
+{
+  arma::vec::fixed<6> Vb;
+  std::memcpy(Vb.memptr(), record.data, 6 * sizeof(double));
+
+  return Vb;
+}
+
+InputLogger::InputLogger(const std::string& path, uint32_t capacity, double flush_period)
+  : path_(path)
+  , capacity_(capacity)
+  , flush_period_(flush_period)
+  , map_size_(sizeof(CaptureFileHeader) + capacity * sizeof(InputRecord))
+  , header_(nullptr)
+  , records_(nullptr)
+  , flushing_(false)
+{
+  static_assert(std::is_trivially_copyable_v<InputRecord>,
+                "capture records must be trivially copyable");
+
+  const auto fd = open(path_.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+  if (fd < 0)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Failed to open capture log: %s", path_.c_str());
+    return;
+  }
+
+  if (ftruncate(fd, static_cast<off_t>(map_size_)) != 0)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Failed to size capture log: %s", path_.c_str());
+    close(fd);
+    return;
+  }
+
+  void* mem = mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (mem == MAP_FAILED)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Failed to map capture log: %s", path_.c_str());
+    return;
+  }
+
+  header_ = static_cast<CaptureFileHeader*>(mem);
+  records_ = reinterpret_cast<InputRecord*>(header_ + 1);
+
+  std::memcpy(header_->magic, CAPTURE_MAGIC, sizeof(header_->magic));
+  header_->record_size = sizeof(InputRecord);
+  header_->capacity = capacity_;
+  header_->written.store(0, std::memory_order_relaxed);
+
+  flushing_ = true;
+  flush_thread_ = std::thread(&InputLogger::flushLoop, this);
+
+  ROS_INFO_NAMED(LOGNAME, "Capturing inputs to %s (%u record ring)", path_.c_str(),
+                 capacity_);
+}
+
+InputLogger::~InputLogger()
+{
+  if (flushing_)
+  {
+    flushing_ = false;
+    flush_thread_.join();
+  }
+
+  if (header_ != nullptr)
+  {
+    msync(header_, map_size_, MS_SYNC);
+    munmap(header_, map_size_);
+  }
+}
+
+bool InputLogger::valid() const
+{
+  return header_ != nullptr;
+}
+
+void InputLogger::log(const InputRecord& record)
+{
+  const auto written = header_->written.load(std::memory_order_relaxed);
+  std::memcpy(&records_[written % capacity_], &record, sizeof(InputRecord));
+  header_->written.store(written + 1, std::memory_order_release);
+}
+
+void InputLogger::flushLoop()
+{
+  const auto period = std::chrono::duration<double>(flush_period_);
+
+  while (flushing_)
+  {
+    std::this_thread::sleep_for(period);
+
+    // Asynchronous writeback keeps the flusher off the page dirty path
+    msync(header_, map_size_, MS_ASYNC);
+  }
+}
+
+bool loadCapture(const std::string& path, std::vector<InputRecord>& records)
+{
+  const auto fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Failed to open capture log: %s", path.c_str());
+    return false;
+  }
+
+  struct stat file_stat = {};
+  if (fstat(fd, &file_stat) != 0 ||
+      static_cast<size_t>(file_stat.st_size) < sizeof(CaptureFileHeader))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Capture log too small: %s", path.c_str());
+    close(fd);
+    return false;
+  }
+
+  const auto map_size = static_cast<size_t>(file_stat.st_size);
+  void* mem = mmap(nullptr, map_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (mem == MAP_FAILED)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Failed to map capture log: %s", path.c_str());
+    return false;
+  }
+
+  const CaptureFileHeader* header = static_cast<const CaptureFileHeader*>(mem);
+  const InputRecord* ring = reinterpret_cast<const InputRecord*>(header + 1);
+
+  if (std::memcmp(header->magic, CAPTURE_MAGIC, sizeof(header->magic)) != 0 ||
+      header->record_size != sizeof(InputRecord))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Capture log schema mismatch: %s", path.c_str());
+    munmap(mem, map_size);
+    return false;
+  }
+
+  const auto written = header->written.load(std::memory_order_acquire);
+  const auto count = std::min<uint64_t>(written, header->capacity);
+  const auto first = written - count;
+
+  records.clear();
+  records.reserve(count);
+  for (uint64_t i = first; i < written; i++)
+  {
+    records.emplace_back(ring[i % header->capacity]);
+  }
+
+  munmap(mem, map_size);
+  return true;
+}
+}  // namespace capture
+}  // namespace quadruped_controller
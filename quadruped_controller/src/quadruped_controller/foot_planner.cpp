@@ -42,6 +42,16 @@ FootPlanner::FootPlanner() : g_(9.81)
   hip_map_.emplace("FR", trans_fr);
 }
 
+FootPlanner::FootPlanner(const TerrainMap& terrain) : FootPlanner()
+{
+  terrain_ = terrain;
+}
+
+void FootPlanner::updateTerrain(const mat& heights)
+{
+  terrain_.update(heights);
+}
+
 tuple<bool, FootholdMap> FootPlanner::positions(double t_stance, const mat33& Rwb,
                                                 const vec3& x, const vec3& xdot,
                                                 const vec3& w, const vec3& xdot_d,
@@ -94,13 +104,11 @@ vec3 FootPlanner::singleFoot(double t_stance, const mat33& Rwb, const vec3& x,
   // based on linear inverted pendulum
   const vec3 p_lip = 0.5 * std::sqrt(x(2) / g_) * xdot;
 
-  // Project on to ground plane (z = 0)
-  vec3 foothold = p_thigh + p_linear + p_tangent + p_lip;
-
-  // TODO: get TF from world to foot link
-  foothold(2) = 0.0;
+  const vec3 foothold = p_thigh + p_linear + p_tangent + p_lip;
 
-  return foothold;
+  // Snap the candidate to valid terrain: on an empty map this projects
+  // onto the ground plane (z = 0)
+  return terrain_.snap(foothold);
 }
 
 std::vector<std::string> FootPlanner::updateStates(const GaitMap& gait_map) const
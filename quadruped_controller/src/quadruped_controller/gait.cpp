@@ -7,6 +7,7 @@
 
 // C++
 #include <chrono>
+#include <cmath>
 
 #include <ros/console.h>
 
@@ -16,11 +17,17 @@
 namespace quadruped_controller
 {
 using math::almost_equal;
-using math::normalize_angle_2PI;
-using math::PI;
 
 static const std::string LOGNAME = "Gait Scheduler";
 
+/** @brief Monotonic clock time (ns) */
+static int64_t monotonic_time_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
 GaitMap make_stance_gait()
 {
   GaitMap gait_map;
@@ -37,37 +44,41 @@ GaitScheduler::GaitScheduler(double t_swing, double t_stance, const vec& offset)
   : t_swing_(t_swing)
   , t_stance_(t_stance)
   , offset_(offset)
-  , phases_(offset)
   , running_(false)
+  , epoch_ns_(0)
+  , elapsed_ns_(0)
 {
   // Stance phase on domain [0 stance_phase_]
   // Swing phase on domain (stance_angle 1)
   stance_phase_ = t_stance_ / (t_swing_ + t_stance_);
 }
 
-GaitScheduler::~GaitScheduler()
-{
-  stop();
-}
-
 void GaitScheduler::start() const
 {
+  if (running_)
+  {
+    ROS_ERROR_STREAM_NAMED(LOGNAME, "GaitScheduler is already running.");
+    return;
+  }
+
   ROS_INFO_STREAM_NAMED(LOGNAME, "Starting GaitScheduler");
+  epoch_ns_ = monotonic_time_ns();
   running_ = true;
-  worker_ = std::thread([this]() { this->execute(); });
 }
 
 void GaitScheduler::stop() const
 {
-  if (worker_.joinable())
+  if (!running_)
   {
-    ROS_INFO_STREAM_NAMED(LOGNAME, "Stopping GaitScheduler");
-    running_ = false;
-    worker_.join();
+    ROS_ERROR_STREAM_NAMED(LOGNAME, "GaitScheduler is not running.");
     return;
   }
 
-  ROS_ERROR_STREAM_NAMED(LOGNAME, "GaitScheduler thread is not joinable.");
+  ROS_INFO_STREAM_NAMED(LOGNAME, "Stopping GaitScheduler");
+
+  // Freeze the phases by folding the current run into the accumulated time
+  elapsed_ns_ += monotonic_time_ns() - epoch_ns_;
+  running_ = false;
 }
 
 void GaitScheduler::reset() const
@@ -79,47 +90,63 @@ void GaitScheduler::reset() const
   }
 
   ROS_INFO_STREAM_NAMED(LOGNAME, "Resetting GaitScheduler");
-  phases_ = offset_;
+  elapsed_ns_ = 0;
 }
 
 GaitMap GaitScheduler::schedule() const
 {
-  const std::lock_guard<std::mutex> lock(mutex_);
-  GaitMap gait_map;
+  // The schedule is a pure function of elapsed time: no locking required
+  const auto t = elapsed() / (t_swing_ + t_stance_);
 
-  gait_map.emplace("RL", std::make_pair(phase(phases_(0)), phases_(0)));
-  gait_map.emplace("FL", std::make_pair(phase(phases_(1)), phases_(1)));
-  gait_map.emplace("RR", std::make_pair(phase(phases_(2)), phases_(2)));
-  gait_map.emplace("FR", std::make_pair(phase(phases_(3)), phases_(3)));
+  GaitMap gait_map;
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
+  {
+    // wrap phase [0 1)
+    const auto leg_phase = std::fmod(offset_(i) + t, 1.0);
+    gait_map.emplace(static_cast<LegId>(i), std::make_pair(phase(leg_phase), leg_phase));
+  }
 
   return gait_map;
 }
 
-void GaitScheduler::execute() const
+void GaitScheduler::scheduleHorizon(double t_start, double dt, unsigned int horizon,
+                                    arma::Mat<unsigned int>& contacts, mat& phases) const
 {
-  auto start = std::chrono::steady_clock::now();
-  while (running_)
-  {
-    const auto current = std::chrono::steady_clock::now();
-    const auto dt = std::chrono::duration<double>(current - start).count();
-    start = current;
+  // set_size is a no-op when the dimensions already match
+  contacts.set_size(horizon, NUM_LEGS);
+  phases.set_size(horizon, NUM_LEGS);
 
-    update(dt);
+  const auto period = t_swing_ + t_stance_;
+  const auto t0 = (elapsed() + t_start) / period;
+  const auto dphase = dt / period;
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(5));  // 200 Hz
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
+  {
+    auto leg_phase = std::fmod(offset_(i) + t0, 1.0);
+    for (unsigned int k = 0; k < horizon; k++)
+    {
+      phases(k, i) = leg_phase;
+      contacts(k, i) = (phase(leg_phase) == LegState::stance) ? 1 : 0;
+
+      // wrap phase [0 1)
+      leg_phase += dphase;
+      if (leg_phase >= 1.0)
+      {
+        leg_phase -= 1.0;
+      }
+    }
   }
 }
 
-void GaitScheduler::update(double dt) const
+double GaitScheduler::elapsed() const
 {
-  const std::lock_guard<std::mutex> lock(mutex_);
-  phases_ += 1.0 / (t_swing_ + t_stance_) * dt;
-
-  // wrap phases [0 1)
-  phases_(0) = std::fmod(phases_(0), 1.0);
-  phases_(1) = std::fmod(phases_(1), 1.0);
-  phases_(2) = std::fmod(phases_(2), 1.0);
-  phases_(3) = std::fmod(phases_(3), 1.0);
+  auto elapsed_ns = elapsed_ns_.load();
+  if (running_)
+  {
+    elapsed_ns += monotonic_time_ns() - epoch_ns_.load();
+  }
+
+  return static_cast<double>(elapsed_ns) * 1.0e-9;
 }
 
 LegState GaitScheduler::phase(double phase) const
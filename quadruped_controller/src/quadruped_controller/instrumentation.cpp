@@ -0,0 +1,213 @@
+/**
+ * @file instrumentation.cpp
+ * @date 2021-10-16
+ * @author Boston Cleek
+ * @brief Hot path latency instrumentation
+ */
+
+// C++
+#include <algorithm>
+#include <bit>
+#include <chrono>
+
+// ROS
+#include <ros/time.h>
+
+#include <quadruped_controller/instrumentation.hpp>
+
+namespace quadruped_controller
+{
+namespace instrumentation
+{
+uint64_t time_now_ns()
+{
+  return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch() /
+                               std::chrono::nanoseconds(1));
+}
+
+LatencyHistogram::LatencyHistogram() : max_ns_(0)
+{
+  for (auto& bin : bins_)
+  {
+    bin.store(0, std::memory_order_relaxed);
+  }
+}
+
+unsigned int LatencyHistogram::bin(uint64_t duration_ns)
+{
+  // bin i covers durations [2^(i-1), 2^i)
+  return std::min(static_cast<unsigned int>(std::bit_width(duration_ns)), num_bins_ - 1);
+}
+
+void LatencyHistogram::record(uint64_t duration_ns)
+{
+  bins_.at(bin(duration_ns)).fetch_add(1, std::memory_order_relaxed);
+
+  auto max = max_ns_.load(std::memory_order_relaxed);
+  while (duration_ns > max &&
+         !max_ns_.compare_exchange_weak(max, duration_ns, std::memory_order_relaxed))
+  {
+  }
+}
+
+LatencyHistogram::Summary LatencyHistogram::summarize()
+{
+  std::array<uint64_t, num_bins_> counts{};
+
+  Summary summary;
+  for (unsigned int i = 0; i < num_bins_; i++)
+  {
+    counts.at(i) = bins_.at(i).exchange(0, std::memory_order_relaxed);
+    summary.samples += counts.at(i);
+  }
+
+  summary.max_ns = max_ns_.exchange(0, std::memory_order_relaxed);
+
+  if (summary.samples == 0)
+  {
+    return summary;
+  }
+
+  // Percentiles resolve to the upper bound of the bin they fall in
+  const auto percentile = [&counts, &summary](double p) -> uint64_t {
+    const auto rank = static_cast<uint64_t>(p * static_cast<double>(summary.samples - 1));
+
+    uint64_t cumulative = 0;
+    for (unsigned int i = 0; i < num_bins_; i++)
+    {
+      cumulative += counts.at(i);
+      if (cumulative > rank)
+      {
+        return i == 0 ? 0 : (1ull << i);
+      }
+    }
+
+    return summary.max_ns;
+  };
+
+  summary.p50_ns = percentile(0.5);
+  summary.p99_ns = percentile(0.99);
+
+  return summary;
+}
+
+PipelineProfiler::PipelineProfiler(const std::vector<std::string>& stage_names,
+                                   bool enabled)
+  : enabled_(enabled)
+  , stage_names_(stage_names)
+  , histograms_(stage_names.size())
+  , last_ns_(stage_names.size())
+{
+}
+
+void PipelineProfiler::record(unsigned int stage, uint64_t duration_ns) const
+{
+  if (enabled_)
+  {
+    histograms_.at(stage).record(duration_ns);
+    last_ns_.at(stage).store(duration_ns, std::memory_order_relaxed);
+  }
+}
+
+void PipelineProfiler::resetStageDurations() const
+{
+  for (auto& last : last_ns_)
+  {
+    last.store(0, std::memory_order_relaxed);
+  }
+}
+
+std::pair<unsigned int, uint64_t> PipelineProfiler::slowestStage() const
+{
+  auto slowest = std::make_pair(0u, uint64_t{ 0 });
+  for (unsigned int i = 0; i < last_ns_.size(); i++)
+  {
+    const auto duration_ns = last_ns_.at(i).load(std::memory_order_relaxed);
+    if (duration_ns > slowest.second)
+    {
+      slowest = { i, duration_ns };
+    }
+  }
+
+  return slowest;
+}
+
+bool PipelineProfiler::enabled() const
+{
+  return enabled_;
+}
+
+quadruped_msgs::LatencyProfile PipelineProfiler::report() const
+{
+  quadruped_msgs::LatencyProfile profile_msg;
+  profile_msg.header.stamp = ros::Time::now();
+  profile_msg.stages.resize(stage_names_.size());
+
+  for (unsigned int i = 0; i < stage_names_.size(); i++)
+  {
+    const LatencyHistogram::Summary summary = histograms_.at(i).summarize();
+
+    profile_msg.stages.at(i).stage = stage_names_.at(i);
+    profile_msg.stages.at(i).samples = summary.samples;
+    profile_msg.stages.at(i).p50_ns = summary.p50_ns;
+    profile_msg.stages.at(i).p99_ns = summary.p99_ns;
+    profile_msg.stages.at(i).max_ns = summary.max_ns;
+  }
+
+  return profile_msg;
+}
+
+DeadlineMonitor::DeadlineMonitor(uint64_t budget_ns, unsigned int degrade_after)
+  : budget_ns_(budget_ns), degrade_after_(degrade_after)
+{
+}
+
+void DeadlineMonitor::beginCycle()
+{
+  cycle_start_ns_ = time_now_ns();
+}
+
+DeadlineMonitor::CycleReport DeadlineMonitor::endCycle()
+{
+  CycleReport report;
+  report.duration_ns = time_now_ns() - cycle_start_ns_;
+  report.overrun = (report.duration_ns > budget_ns_);
+
+  const auto was_degraded = degraded_;
+
+  if (report.overrun)
+  {
+    overruns_++;
+    consecutive_overruns_++;
+    consecutive_in_budget_ = 0;
+
+    if (consecutive_overruns_ >= degrade_after_)
+    {
+      degraded_ = true;
+    }
+  }
+  else
+  {
+    consecutive_overruns_ = 0;
+    consecutive_in_budget_++;
+
+    if (degraded_ && consecutive_in_budget_ >= degrade_after_)
+    {
+      degraded_ = false;
+    }
+  }
+
+  report.degraded = degraded_;
+  report.degraded_changed = (degraded_ != was_degraded);
+  report.overruns = overruns_;
+  report.consecutive_overruns = consecutive_overruns_;
+
+  return report;
+}
+
+bool DeadlineMonitor::degraded() const
+{
+  return degraded_;
+}
+}  // namespace instrumentation
+}  // namespace quadruped_controller
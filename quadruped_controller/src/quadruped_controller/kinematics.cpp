@@ -46,6 +46,21 @@ QuadrupedKinematics::QuadrupedKinematics()
   link_map_.emplace("RR", std::pair(trans_rr, right_links));
   link_map_.emplace("FR", std::pair(trans_fr, right_links));
 
+  // SoA constants for the batched kernels (index = LegId)
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
+  {
+    const auto& [trans_bh, leg_links] = link_map_.at(static_cast<LegId>(i));
+
+    hip_x_.at(i) = trans_bh(0);
+    hip_y_.at(i) = trans_bh(1);
+    hip_z_.at(i) = trans_bh(2);
+    l1_.at(i) = leg_links(0);
+    right_leg_.at(i) = (static_cast<LegId>(i) == RR) || (static_cast<LegId>(i) == FR);
+  }
+
+  l2_ = left_links(1);
+  l3_ = left_links(2);
+
   // TEST
   // vec q = {0.63, 1.04, -1.60};
 
@@ -69,11 +84,10 @@ mat QuadrupedKinematics::forwardKinematics(const vec& q) const
   // Follows joint_state topic format: RL, FL, RR, FR
   // Foot position relative to base frame
   // Each column is a foot position (x,y,z)
-  mat ft_p(3, 4);
-  ft_p.col(0) = forwardKinematics("RL", q.rows(0, 2));
-  ft_p.col(1) = forwardKinematics("FL", q.rows(3, 5));
-  ft_p.col(2) = forwardKinematics("RR", q.rows(6, 8));
-  ft_p.col(3) = forwardKinematics("FR", q.rows(9, 11));
+  const mat::fixed<3, 4> qs = arma::reshape(q, 3, 4);
+
+  mat::fixed<3, 4> ft_p;
+  forwardKinematicsAll(qs, ft_p);
 
   return ft_p;
 }
@@ -102,13 +116,54 @@ vec3 QuadrupedKinematics::forwardKinematics(const std::string& leg_name,
   return foot_position;
 }
 
+void QuadrupedKinematics::forwardKinematicsAll(const mat::fixed<3, 4>& q,
+                                               mat::fixed<3, 4>& ft_p) const
+{
+  // Trigonometric terms evaluated once for all legs
+  double s1[NUM_LEGS], c1[NUM_LEGS];
+  double s2[NUM_LEGS], c2[NUM_LEGS];
+  double s23[NUM_LEGS], c23[NUM_LEGS];
+
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
+  {
+    const auto t1 = q(0, i);
+    const auto t2 = q(1, i);
+    const auto t23 = q(1, i) + q(2, i);
+
+    s1[i] = sin(t1);
+    c1[i] = cos(t1);
+    s2[i] = sin(t2);
+    c2[i] = cos(t2);
+    s23[i] = sin(t23);
+    c23[i] = cos(t23);
+  }
+
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
+  {
+    ft_p(0, i) = l2_ * s2[i] + l3_ * s23[i] + hip_x_.at(i);
+    ft_p(1, i) =
+        l1_.at(i) * c1[i] - l2_ * s1[i] * c2[i] - l3_ * s1[i] * c23[i] + hip_y_.at(i);
+    ft_p(2, i) =
+        l1_.at(i) * s1[i] + l2_ * c1[i] * c2[i] + l3_ * c1[i] * c23[i] + hip_z_.at(i);
+  }
+}
+
 FootholdMap
 QuadrupedKinematics::forwardKinematics(const JointStatesMap& joint_states_map) const
 {
+  mat::fixed<3, 4> qs;
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
+  {
+    qs.col(i) = joint_states_map.at(static_cast<LegId>(i)).q;
+  }
+
+  mat::fixed<3, 4> ft_p;
+  forwardKinematicsAll(qs, ft_p);
+
   FootholdMap foot_hold_map;
-  for (const auto& [leg_name, joint_states] : joint_states_map)
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
   {
-    foot_hold_map.emplace(leg_name, forwardKinematics(leg_name, joint_states.q));
+    foot_hold_map.emplace(static_cast<LegId>(i), ft_p.col(i));
   }
 
   return foot_hold_map;
@@ -159,6 +214,48 @@ vec3 QuadrupedKinematics::legInverseKinematics(const std::string& leg_name,
   return q;
 }
 
+void QuadrupedKinematics::inverseKinematicsAll(const mat::fixed<3, 4>& ft_p,
+                                               mat::fixed<3, 4>& q) const
+{
+  const auto l1 = links_(0);
+  const auto l2 = links_(1);
+  const auto l3 = links_(2);
+
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
+  {
+    // position of foot relative to hip
+    const auto x = ft_p(0, i) - hip_x_.at(i);
+    const auto y = ft_p(1, i) - hip_y_.at(i);
+    const auto z = ft_p(2, i) - hip_z_.at(i);
+
+    auto d = (x * x + y * y + z * z - l1 * l1 - l2 * l2 - l3 * l3) / (2.0 * l2 * l3);
+
+    if (d > 1.0)
+    {
+      d = 1.0;
+    }
+
+    auto sqrt_component = y * y + z * z - l1 * l1;
+    if (sqrt_component < 0.0)
+    {
+      sqrt_component = 0.0;
+    }
+
+    if (right_leg_.at(i))
+    {
+      q(0, i) = atan2(z, y) + atan2(sqrt(sqrt_component), -l1);
+    }
+    else
+    {
+      q(0, i) = -(atan2(z, -y) + atan2(sqrt(sqrt_component), -l1));
+    }
+
+    q(2, i) = atan2(-sqrt(1.0 - d * d), d);
+    q(1, i) = -atan2(x, sqrt(sqrt_component)) -
+              atan2(l3 * sin(q(2, i)), l2 + l3 * cos(q(2, i)));
+  }
+}
+
 mat33 QuadrupedKinematics::legJacobian(const std::string& leg_name, const vec3& q) const
 {
   const vec3 links = link_map_.at(leg_name).second;
@@ -187,6 +284,47 @@ mat33 QuadrupedKinematics::legJacobian(const std::string& leg_name, const vec3&
   return jac;
 }
 
+void QuadrupedKinematics::jacobiansAll(const mat::fixed<3, 4>& q,
+                                       std::array<mat33, NUM_LEGS>& jacobians) const
+{
+  // Trigonometric terms evaluated once for all legs
+  double s1[NUM_LEGS], c1[NUM_LEGS];
+  double s2[NUM_LEGS], c2[NUM_LEGS];
+  double s23[NUM_LEGS], c23[NUM_LEGS];
+
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
+  {
+    const auto t1 = q(0, i);
+    const auto t2 = q(1, i);
+    const auto t23 = q(1, i) + q(2, i);
+
+    s1[i] = sin(t1);
+    c1[i] = cos(t1);
+    s2[i] = sin(t2);
+    c2[i] = cos(t2);
+    s23[i] = sin(t23);
+    c23[i] = cos(t23);
+  }
+
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
+  {
+    mat33& jac = jacobians.at(i);
+    const auto l1 = l1_.at(i);
+
+    jac(0, 0) = 0.0;
+    jac(0, 1) = l2_ * c2[i] + l3_ * c23[i];
+    jac(0, 2) = l3_ * c23[i];
+
+    jac(1, 0) = -l1 * s1[i] - l2_ * c1[i] * c2[i] - l3_ * c1[i] * c23[i];
+    jac(1, 1) = (l2_ * s2[i] + l3_ * s23[i]) * s1[i];
+    jac(1, 2) = l3_ * s1[i] * s23[i];
+
+    jac(2, 0) = l1 * c1[i] - l2_ * s1[i] * c2[i] - l3_ * s1[i] * c23[i];
+    jac(2, 1) = -(l2_ * s2[i] + l3_ * s23[i]) * c1[i];
+    jac(2, 2) = -l3_ * s23[i] * c1[i];
+  }
+}
+
 mat33 QuadrupedKinematics::legJacobianInverse(const std::string& leg_name,
                                               const vec3& q) const
 {
@@ -219,15 +357,45 @@ TorqueMap
 QuadrupedKinematics::jacobianTransposeControl(const JointStatesMap& joint_states_map,
                                               const ForceMap& force_map) const
 {
+  mat::fixed<3, 4> qs;
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
+  {
+    qs.col(i) = joint_states_map.at(static_cast<LegId>(i)).q;
+  }
+
+  std::array<mat33, NUM_LEGS> jacobians;
+  jacobiansAll(qs, jacobians);
+
   TorqueMap torque_map;
   for (const auto& [leg_name, force] : force_map)
   {
-    const mat33 J = legJacobian(leg_name, joint_states_map.at(leg_name).q);
-    const vec3 tau = J.t() * force;
-    torque_map.emplace(leg_name, tau);
+    const auto id = leg_id(leg_name);
+    const vec3 tau = jacobians.at(id).t() * force;
+    torque_map.emplace(id, tau);
   }
 
   return torque_map;
 }
 
+void QuadrupedKinematics::jacobianTransposeControl(
+    const mat::fixed<3, 4>& q, const mat::fixed<3, 4>& f,
+    const mat::fixed<3, 4>& tau_swing, const std::array<bool, NUM_LEGS>& stance,
+    vec::fixed<12>& tau) const
+{
+  std::array<mat33, NUM_LEGS> jacobians;
+  jacobiansAll(q, jacobians);
+
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
+  {
+    if (stance.at(i))
+    {
+      tau.rows(i * 3, i * 3 + 2) = jacobians.at(i).t() * f.col(i);
+    }
+    else
+    {
+      tau.rows(i * 3, i * 3 + 2) = tau_swing.col(i);
+    }
+  }
+}
+
 }  // namespace quadruped_controller
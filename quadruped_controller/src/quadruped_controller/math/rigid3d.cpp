@@ -20,47 +20,9 @@ namespace math
 using std::cos;
 using std::sin;
 
-mat eigen_to_arma(const Eigen::MatrixXd& R_eigen)
+mat33 skew_symmetric(const vec3& x)
 {
-  // Read only from R_eigen in memory
-  // This is a copy operation for safety
-  return mat(R_eigen.data(), R_eigen.rows(), R_eigen.cols());
-}
-
-// vec eigen_to_arma(const Eigen::VectorXd& p_eigen)
-// {
-//   return mat(p_eigen.data(), p_eigen.rows(), p_eigen.cols());
-// }
-
-Eigen::Matrix3d arma_rotation_to_eigen(const mat& R_arma)
-{
-  // Copy data over for safety
-  // If Armadillo's memptr() is used
-  // this violates the input arguments const
-  Eigen::Matrix3d R_eigen;
-  R_eigen(0, 0) = R_arma(0, 0);
-  R_eigen(0, 1) = R_arma(0, 1);
-  R_eigen(0, 2) = R_arma(0, 2);
-
-  R_eigen(1, 0) = R_arma(1, 0);
-  R_eigen(1, 1) = R_arma(1, 1);
-  R_eigen(1, 2) = R_arma(1, 2);
-
-  R_eigen(2, 0) = R_arma(2, 0);
-  R_eigen(2, 1) = R_arma(2, 1);
-  R_eigen(2, 2) = R_arma(2, 2);
-
-  return R_eigen;
-}
-
-Eigen::Vector3d arma_translation_to_eigen(const vec3& p)
-{
-  return Eigen::Vector3d(p(0), p(1), p(2));
-}
-
-mat skew_symmetric(const vec3& x)
-{
-  mat skew(3, 3, arma::fill::zeros);
+  mat33 skew(arma::fill::zeros);
   // upper
   skew(0, 1) = -x(2);
   skew(0, 2) = x(1);
@@ -75,29 +37,68 @@ mat skew_symmetric(const vec3& x)
 
 /////////////////////////////////////////////////////////
 // Quaternion
-Quaternion::Quaternion() : q_(1., 0., 0., 0.)
+Quaternion::Quaternion() : qw_(1.), qx_(0.), qy_(0.), qz_(0.)
 {
 }
 
-Quaternion::Quaternion(double qw, double qx, double qy, double qz) : q_(qw, qx, qy, qz)
+Quaternion::Quaternion(double qw, double qx, double qy, double qz)
+  : qw_(qw), qx_(qx), qy_(qy), qz_(qz)
 {
 }
 
-Quaternion::Quaternion(const Eigen::Quaterniond& q) : q_(q)
+Quaternion::Quaternion(const Rotation3d& R) : Quaternion(R.matrix())
 {
 }
 
-Quaternion::Quaternion(const Rotation3d& R) : q_(R.toEigenQuaternion())
+Quaternion::Quaternion(const mat& R)
 {
-}
+  // Shepperd's method: pick the largest of the four candidate
+  // components to stay numerically stable near every rotation
+  const auto trace = R(0, 0) + R(1, 1) + R(2, 2);
 
-Quaternion::Quaternion(const mat& R) : q_(Rotation3d(R).toEigenQuaternion())
-{
+  if (trace > 0.0)
+  {
+    const auto s = 2.0 * std::sqrt(trace + 1.0);
+    qw_ = 0.25 * s;
+    qx_ = (R(2, 1) - R(1, 2)) / s;
+    qy_ = (R(0, 2) - R(2, 0)) / s;
+    qz_ = (R(1, 0) - R(0, 1)) / s;
+  }
+  else if (R(0, 0) > R(1, 1) && R(0, 0) > R(2, 2))
+  {
+    const auto s = 2.0 * std::sqrt(1.0 + R(0, 0) - R(1, 1) - R(2, 2));
+    qw_ = (R(2, 1) - R(1, 2)) / s;
+    qx_ = 0.25 * s;
+    qy_ = (R(0, 1) + R(1, 0)) / s;
+    qz_ = (R(0, 2) + R(2, 0)) / s;
+  }
+  else if (R(1, 1) > R(2, 2))
+  {
+    const auto s = 2.0 * std::sqrt(1.0 + R(1, 1) - R(0, 0) - R(2, 2));
+    qw_ = (R(0, 2) - R(2, 0)) / s;
+    qx_ = (R(0, 1) + R(1, 0)) / s;
+    qy_ = 0.25 * s;
+    qz_ = (R(1, 2) + R(2, 1)) / s;
+  }
+  else
+  {
+    const auto s = 2.0 * std::sqrt(1.0 + R(2, 2) - R(0, 0) - R(1, 1));
+    qw_ = (R(1, 0) - R(0, 1)) / s;
+    qx_ = (R(0, 2) + R(2, 0)) / s;
+    qy_ = (R(1, 2) + R(2, 1)) / s;
+    qz_ = 0.25 * s;
+  }
 }
 
 Quaternion::Quaternion(double angle, const vec3& axis)
-  : q_(Eigen::AngleAxisd(angle, arma_translation_to_eigen(axis)))
 {
+  const vec3 unit_axis = arma::normalise(axis);
+  const auto half_sin = sin(0.5 * angle);
+
+  qw_ = cos(0.5 * angle);
+  qx_ = unit_axis(0) * half_sin;
+  qy_ = unit_axis(1) * half_sin;
+  qz_ = unit_axis(2) * half_sin;
 }
 
 Rotation3d Quaternion::rotation() const
@@ -105,15 +106,44 @@ Rotation3d Quaternion::rotation() const
   return Rotation3d(*this);
 }
 
-mat Quaternion::matrix() const
+mat33 Quaternion::matrix() const
 {
-  return Rotation3d(*this).matrix();
+  mat33 R;
+  R(0, 0) = 1.0 - 2.0 * (qy_ * qy_ + qz_ * qz_);
+  R(0, 1) = 2.0 * (qx_ * qy_ - qw_ * qz_);
+  R(0, 2) = 2.0 * (qx_ * qz_ + qw_ * qy_);
+
+  R(1, 0) = 2.0 * (qx_ * qy_ + qw_ * qz_);
+  R(1, 1) = 1.0 - 2.0 * (qx_ * qx_ + qz_ * qz_);
+  R(1, 2) = 2.0 * (qy_ * qz_ - qw_ * qx_);
+
+  R(2, 0) = 2.0 * (qx_ * qz_ - qw_ * qy_);
+  R(2, 1) = 2.0 * (qy_ * qz_ + qw_ * qx_);
+  R(2, 2) = 1.0 - 2.0 * (qx_ * qx_ + qy_ * qy_);
+
+  return R;
 }
 
 vec3 Quaternion::eulerAngles() const
 {
-  const drake::math::RollPitchYaw angles(q_);
-  return { angles.roll_angle(), angles.pitch_angle(), angles.yaw_angle() };
+  const auto roll =
+      std::atan2(2.0 * (qw_ * qx_ + qy_ * qz_), 1.0 - 2.0 * (qx_ * qx_ + qy_ * qy_));
+
+  auto sin_pitch = 2.0 * (qw_ * qy_ - qz_ * qx_);
+  if (sin_pitch > 1.0)
+  {
+    sin_pitch = 1.0;
+  }
+  else if (sin_pitch < -1.0)
+  {
+    sin_pitch = -1.0;
+  }
+  const auto pitch = std::asin(sin_pitch);
+
+  const auto yaw =
+      std::atan2(2.0 * (qw_ * qz_ + qx_ * qy_), 1.0 - 2.0 * (qy_ * qy_ + qz_ * qz_));
+
+  return { roll, pitch, yaw };
 }
 
 void Quaternion::print(const std::string& msg) const
@@ -122,14 +152,13 @@ void Quaternion::print(const std::string& msg) const
   {
     std::cout << msg << "\n";
   }
-  std::cout << "qw: " << q_.w() << " qx: " << q_.x() << " qy: " << q_.y()
-            << " qz: " << q_.z() << std::endl;
+  std::cout << "qw: " << qw_ << " qx: " << qx_ << " qy: " << qy_ << " qz: " << qz_
+            << std::endl;
 }
 
 bool Quaternion::isUnit() const
 {
-  const auto norm =
-      std::sqrt(q_.x() * q_.x() + q_.y() * q_.y() + q_.z() * q_.z() + q_.w() * q_.w());
+  const auto norm = std::sqrt(qx_ * qx_ + qy_ * qy_ + qz_ * qz_ + qw_ * qw_);
 
   if (almost_equal(norm, 1.0))
   {
@@ -139,87 +168,101 @@ bool Quaternion::isUnit() const
   return false;
 }
 
-const Eigen::Quaterniond& Quaternion::data() const
-{
-  return q_;
-}
-
 double Quaternion::w() const
 {
-  return q_.w();
+  return qw_;
 }
 
 double Quaternion::x() const
 {
-  return q_.x();
+  return qx_;
 }
 
 double Quaternion::y() const
 {
-  return q_.y();
+  return qy_;
 }
 
 double Quaternion::z() const
 {
-  return q_.z();
+  return qz_;
 }
 
 /////////////////////////////////////////////////////////
 // Rotation
-Rotation3d::Rotation3d()
+Rotation3d::Rotation3d() : R_(arma::fill::eye)
 {
 }
 
-Rotation3d::Rotation3d(const Quaternion& quaternion) : R_(quaternion.data())
+Rotation3d::Rotation3d(const Quaternion& quaternion) : R_(quaternion.matrix())
 {
 }
 
-Rotation3d::Rotation3d(const mat& R) : R_(arma_rotation_to_eigen(R))
+Rotation3d::Rotation3d(const mat& R) : R_(R)
 {
 }
 
 Rotation3d::Rotation3d(double roll, double pitch, double yaw)
-  : R_(drake::math::RollPitchYaw<double>(roll, pitch, yaw))
 {
+  const auto cr = cos(roll);
+  const auto sr = sin(roll);
+  const auto cp = cos(pitch);
+  const auto sp = sin(pitch);
+  const auto cy = cos(yaw);
+  const auto sy = sin(yaw);
+
+  // R = Rz(yaw) * Ry(pitch) * Rx(roll)
+  R_(0, 0) = cy * cp;
+  R_(0, 1) = cy * sp * sr - sy * cr;
+  R_(0, 2) = cy * sp * cr + sy * sr;
+
+  R_(1, 0) = sy * cp;
+  R_(1, 1) = sy * sp * sr + cy * cr;
+  R_(1, 2) = sy * sp * cr - cy * sr;
+
+  R_(2, 0) = -sp;
+  R_(2, 1) = cp * sr;
+  R_(2, 2) = cp * cr;
 }
 
 vec3 Rotation3d::operator*(const vec3& p) const
 {
-  return matrix() * p;
+  return R_ * p;
 }
 
 tuple<vec, double> Rotation3d::angleAxis() const
 {
-  const Eigen::AngleAxisd aa_eigen = R_.ToAngleAxis();
-  const vec axis = { aa_eigen.axis()(0), aa_eigen.axis()(1), aa_eigen.axis()(2) };
-  return { axis, aa_eigen.angle() };
-}
+  // The quaternion form is stable for angles near both 0 and pi
+  const Quaternion q = toQuaternion();
+  const vec3 v = { q.x(), q.y(), q.z() };
+  const auto v_norm = arma::norm(v);
 
-vec Rotation3d::angleAxisTotal() const
-{
-  const Eigen::AngleAxisd aa_eigen = R_.ToAngleAxis();
-  const Eigen::Vector3d aa_tot_eigen = aa_eigen.axis() * aa_eigen.angle();
-  return { aa_tot_eigen(0), aa_tot_eigen(1), aa_tot_eigen(2) };
+  if (almost_equal(v_norm, 0.0))
+  {
+    const vec axis = { 1.0, 0.0, 0.0 };
+    return { axis, 0.0 };
+  }
+
+  const vec axis = v / v_norm;
+  const auto angle = 2.0 * std::atan2(v_norm, q.w());
+
+  return { axis, angle };
 }
 
-mat Rotation3d::matrix() const
+vec Rotation3d::angleAxisTotal() const
 {
-  return eigen_to_arma(R_.matrix());
+  const auto [axis, angle] = angleAxis();
+  return axis * angle;
 }
 
-const drake::math::RotationMatrix<double>& Rotation3d::data() const
+const mat33& Rotation3d::matrix() const
 {
   return R_;
 }
 
 Quaternion Rotation3d::toQuaternion() const
 {
-  return Quaternion(R_.ToQuaternion());
-}
-
-Eigen::Quaterniond Rotation3d::toEigenQuaternion() const
-{
-  return R_.ToQuaternion();
+  return Quaternion(R_);
 }
 
 void Rotation3d::print(const std::string& msg) const
@@ -229,90 +272,81 @@ void Rotation3d::print(const std::string& msg) const
 
 /////////////////////////////////////////////////////////
 // Transformation
-Transform3d::Transform3d()
-{
-}
-
-Transform3d::Transform3d(const vec3& p) : T_(arma_translation_to_eigen(p))
+Transform3d::Transform3d() : R_(arma::fill::eye), p_(arma::fill::zeros)
 {
 }
 
-Transform3d::Transform3d(const drake::math::RigidTransform<double>& T) : T_(T)
+Transform3d::Transform3d(const vec3& p) : R_(arma::fill::eye), p_(p)
 {
 }
 
-Transform3d::Transform3d(const Quaternion& q, const vec3& p)
-  : T_(q.data(), arma_translation_to_eigen(p))
+Transform3d::Transform3d(const Quaternion& q, const vec3& p) : R_(q.matrix()), p_(p)
 {
 }
 
-Transform3d::Transform3d(const Rotation3d& R, const vec3& p)
-  : T_(R.data(), arma_translation_to_eigen(p))
+Transform3d::Transform3d(const Rotation3d& R, const vec3& p) : R_(R.matrix()), p_(p)
 {
 }
 
-Transform3d::Transform3d(const mat& R, const vec3& p)
-  : T_(Quaternion(R).data(), arma_translation_to_eigen(p))
+Transform3d::Transform3d(const mat& R, const vec3& p) : R_(R), p_(p)
 {
 }
 
-mat Transform3d::adjoint() const
+mat::fixed<6, 6> Transform3d::adjoint() const
 {
   // Assumes twist is [vy, vy, vz, wx, wy, wz]
-  mat AdT(6, 6, arma::fill::zeros);
-  const mat T = eigen_to_arma(T_.GetAsMatrix34());
-  const mat R_transpose = T.submat(0, 0, 2, 2).t();
+  mat::fixed<6, 6> AdT(arma::fill::zeros);
+  const mat33 R_transpose = R_.t();
 
   AdT.submat(0, 0, 2, 2) = R_transpose;
   AdT.submat(3, 3, 5, 5) = R_transpose;
-  AdT.submat(0, 3, 2, 5) = -1.0 * R_transpose * skew_symmetric(T.col(3));
+  AdT.submat(0, 3, 2, 5) = -1.0 * R_transpose * skew_symmetric(p_);
 
   return AdT;
 }
 
 tuple<Quaternion, vec3> Transform3d::components() const
 {
-  const mat T = eigen_to_arma(T_.GetAsMatrix34());
-  return std::make_tuple(Quaternion(T.submat(0, 0, 2, 2)), T.submat(0, 3, 2, 3));
+  return std::make_tuple(Quaternion(R_), p_);
 }
 
 Quaternion Transform3d::getQuaternion() const
 {
-  const mat T = eigen_to_arma(T_.GetAsMatrix34());
-  return Quaternion(T.submat(0, 0, 2, 2));
+  return Quaternion(R_);
 }
 
 vec3 Transform3d::getTranslation() const
 {
-  const Eigen::Vector3d t_eigen = T_.translation();
-  return { t_eigen(0), t_eigen(1), t_eigen(2) };
+  return p_;
 }
 
 Transform3d Transform3d::operator*(const Transform3d& T) const
 {
-  return Transform3d(T_ * T.data());
+  return Transform3d(mat(R_ * T.R_), vec3(R_ * T.p_ + p_));
 }
 
 vec3 Transform3d::operator*(const vec3& p) const
 {
-  const mat T = eigen_to_arma(T_.GetAsMatrix34());
   // rotation followed by translation
-  return T.submat(0, 0, 2, 2) * p + T.col(3);
+  return R_ * p + p_;
 }
 
-const drake::math::RigidTransform<double>& Transform3d::data() const
+mat44 Transform3d::inverse() const
 {
-  return T_;
-}
+  mat44 T(arma::fill::eye);
+  T.submat(0, 0, 2, 2) = R_.t();
+  T.submat(0, 3, 2, 3) = -1.0 * R_.t() * p_;
 
-mat Transform3d::inverse() const
-{
-  return eigen_to_arma(T_.inverse().GetAsMatrix4());
+  return T;
 }
 
-mat Transform3d::matrix() const
+mat44 Transform3d::matrix() const
 {
-  return eigen_to_arma(T_.GetAsMatrix4());
+  mat44 T(arma::fill::eye);
+  T.submat(0, 0, 2, 2) = R_;
+  T.submat(0, 3, 2, 3) = p_;
+
+  return T;
 }
 
 void Transform3d::print(const std::string& msg) const
@@ -0,0 +1,338 @@
+/**
+ * @file mpc_controller.cpp
+ * @date 2021-09-18
+ * @author Boston Cleek
+ * @brief Convex model predictive controller
+ */
+
+#include <ros/console.h>
+#include <quadruped_controller/mpc_controller.hpp>
+#include <quadruped_controller/balance_controller.hpp>
+
+/*
+References:
+  [R1] M. Focchi, A. del Prete, I. Havoutis, R. Featherstone, D. G. Caldwell,
+      and C. Semini. High-slope terrain locomotion for torque-controlled quadruped
+      robots. Autonomous Robots, 2016.
+  [R2] J. Di Carlo, P. M. Wensing, B. Katz, G. Bledt, and S. Kim. Dynamic
+      locomotion in the MIT Cheetah 3 through convex model-predictive control.
+      IEEE/RSJ International Conference on Intelligent Robots and Systems, 2018.
+*/
+
+namespace quadruped_controller
+{
+static const std::string LOGNAME = "MPC Controller";
+
+ConvexMPC::ConvexMPC(double mu, double mass, double fzmin, double fzmax, const mat& Ib,
+                     const vec& Q, double R, unsigned int horizon, double dt,
+                     const std::vector<std::string>& leg_names)
+  : mu_(mu)
+  , mass_(mass)
+  , Ib_(Ib)
+  , horizon_(horizon)
+  , dt_(dt)
+  , Cf_(frictionConeConstraint())
+  , QPSolver_(num_controls_ * horizon, num_constraints_ * horizon)
+  , nWSR_(500)
+  , fzmin_(fzmin)
+  , fzmax_(fzmax)
+  , cpu_time_(0.01)  // must fit in the control loop budget
+  , qp_H_(num_controls_ * horizon * num_controls_ * horizon)
+  , qp_g_(num_controls_ * horizon)
+  , qp_C_(num_constraints_ * horizon * num_controls_ * horizon)
+  , qp_lbC_(num_constraints_ * horizon)
+  , qp_ubC_(num_constraints_ * horizon)
+  , leg_names_(leg_names)
+{
+  // State error weights repeated for every step in the horizon
+  vec q_diag(num_states_ * horizon_);
+  for (unsigned int i = 0; i < horizon_; i++)
+  {
+    q_diag.rows(i * num_states_, (i + 1) * num_states_ - 1) = Q;
+  }
+
+  Q_ = arma::diagmat(q_diag);
+  R_ = eye(num_controls_ * horizon_, num_controls_ * horizon_) * R;
+
+  // The constraint matrix is block diagonal with one cone per leg per
+  // step and never changes - only the bounds track the contact
+  // schedule - so it is filled once here instead of every solve
+  const auto n_cols = num_controls_ * horizon_;
+  for (unsigned int k = 0; k < horizon_; k++)
+  {
+    for (unsigned int leg = 0; leg < 4; leg++)
+    {
+      const auto row0 = k * num_constraints_ + leg * 5;
+      const auto col0 = k * num_controls_ + leg * 3;
+
+      for (unsigned int i = 0; i < 5; i++)
+      {
+        for (unsigned int j = 0; j < 3; j++)
+        {
+          qp_C_.at((row0 + i) * n_cols + col0 + j) = Cf_(i, j);
+        }
+      }
+    }
+  }
+
+  // Disable printing
+  QPSolver_.setPrintLevel(qpOASES::PL_NONE);
+}
+
+ForceMap ConvexMPC::control(const mat& Rwb, const mat& Rwb_d, const vec& x,
+                            const vec& xdot, const vec& w, const vec& x_d,
+                            const vec& xdot_d, const vec& w_d,
+                            const FootholdMap& foot_map, const GaitMap& gait_map,
+                            const arma::Mat<unsigned int>& contact_horizon) const
+{
+  ForceMap force_map;
+  mat ft_p(3, 4, arma::fill::zeros);
+
+  for (unsigned int i = 0; i < leg_names_.size(); i++)
+  {
+    // Populate foot positions
+    ft_p.col(i) = foot_map.at(leg_names_.at(i));
+  }
+
+  // Current and desired euler angles
+  const vec3 euler = Quaternion(Rwb).eulerAngles();
+  const vec3 euler_d = Quaternion(Rwb_d).eulerAngles();
+
+  // Current state [theta, p, w, pdot, g]
+  vec x0(num_states_);
+  x0.rows(0, 2) = euler;
+  x0.rows(3, 5) = x;
+  x0.rows(6, 8) = w;
+  x0.rows(9, 11) = xdot;
+  x0(12) = -9.81;
+
+  // Reference trajectory: integrate the desired velocities forward
+  vec x_ref(num_states_ * horizon_, arma::fill::zeros);
+  for (unsigned int k = 0; k < horizon_; k++)
+  {
+    const auto t = dt_ * static_cast<double>(k + 1);
+    const auto row = k * num_states_;
+
+    x_ref.rows(row, row + 2) = euler_d;
+    x_ref(row + 2) += w_d(2) * t;  // yaw advances at the commanded rate
+    x_ref.rows(row + 3, row + 5) = x_d + xdot_d * t;
+    x_ref.rows(row + 6, row + 8) = w_d;
+    x_ref.rows(row + 9, row + 11) = xdot_d;
+    x_ref(row + 12) = -9.81;
+  }
+
+  // Discrete dynamics linearized about the current yaw angle
+  mat A(num_states_, num_states_);
+  mat B(num_states_, num_controls_);
+  dynamics(ft_p, Rwb, euler(2), A, B);
+
+  // Condense the horizon [R2] Eq(27) and Eq(28).
+  // Aqp = [A; A^2; ...; A^N] (13N x 13)
+  // Bqp is lower block triangular with Bqp(k,j) = A^(k-j-1)*B, so only
+  // the N distinct blocks A^i*B are formed and copied into place.
+  mat Aqp(num_states_ * horizon_, num_states_);
+  mat Bqp(num_states_ * horizon_, num_controls_ * horizon_, arma::fill::zeros);
+
+  // powers[i] = A^i * B
+  std::vector<mat> powers(horizon_);
+  powers.at(0) = B;
+
+  mat Ak = A;  // A^(k+1)
+  for (unsigned int k = 0; k < horizon_; k++)
+  {
+    if (k > 0)
+    {
+      powers.at(k) = Ak * B;
+      Ak = A * Ak;
+    }
+
+    Aqp.rows(k * num_states_, (k + 1) * num_states_ - 1) =
+        (k == 0) ? A : Aqp.rows((k - 1) * num_states_, k * num_states_ - 1) * A;
+
+    for (unsigned int j = 0; j <= k; j++)
+    {
+      Bqp.submat(k * num_states_, j * num_controls_, (k + 1) * num_states_ - 1,
+                 (j + 1) * num_controls_ - 1) = powers.at(k - j);
+    }
+  }
+
+  // QP standard form 1/2*U.T*H*U + U.T*g
+  const mat H = 2.0 * (Bqp.t() * Q_ * Bqp + R_);
+  const vec g = 2.0 * Bqp.t() * Q_ * (Aqp * x0 - x_ref);
+
+  // H is symmetric so no row-major transpose is needed
+  copy_to_real_t_symmetric(H, qp_H_.data());
+  copy_to_real_t(g, qp_g_.data());
+
+  // compose friction cone constraints over the horizon
+  frictionConeBounds(gait_map, contact_horizon);
+
+  // No lower/upper bound constraints on GRFs because
+  // the constraint matrix takes care of this.
+  real_t* qp_lb = nullptr;
+  real_t* qp_ub = nullptr;
+
+  // Will update based on actual
+  int nWSR_acutal = nWSR_;
+  real_t cpu_time_actual = cpu_time_;
+
+  if (!QPSolver_.isInitialised())
+  {
+    const returnValue ret_val =
+        QPSolver_.init(qp_H_.data(), qp_g_.data(), qp_C_.data(), qp_lb, qp_ub,
+                       qp_lbC_.data(), qp_ubC_.data(), nWSR_acutal, &cpu_time_actual);
+
+    if (ret_val != qpOASES::SUCCESSFUL_RETURN)
+    {
+      ROS_ERROR_STREAM_NAMED(LOGNAME, "Failed to initialize MPC QP Solver");
+      return force_map;
+    }
+  }
+
+  else
+  {
+    const returnValue ret_val =
+        QPSolver_.hotstart(qp_H_.data(), qp_g_.data(), qp_C_.data(), qp_lb, qp_ub,
+                           qp_lbC_.data(), qp_ubC_.data(), nWSR_acutal, &cpu_time_actual);
+
+    if (ret_val != qpOASES::SUCCESSFUL_RETURN)
+    {
+      ROS_ERROR_STREAM_NAMED(LOGNAME, "Failed to hotstart MPC QP Solver");
+      return force_map;
+    }
+  }
+
+  // Primal solution over the entire horizon
+  std::vector<real_t> qp_xOpt(num_controls_ * horizon_);
+
+  if (QPSolver_.isSolved())
+  {
+    QPSolver_.getPrimalSolution(qp_xOpt.data());
+  }
+
+  else
+  {
+    ROS_ERROR_STREAM_NAMED(LOGNAME, "MPC QP Solver Failed");
+    return force_map;
+  }
+
+  // Only the first step in the horizon is applied
+  const vec fw = copy_from_real_t(qp_xOpt.data(), num_controls_);
+
+  const mat Rbw = Rwb.t();
+  unsigned int row = 0;
+  unsigned int col = 2;
+  for (const auto& leg_name : leg_names_)
+  {
+    if (gait_map.at(leg_name).first == LegState::stance)
+    {
+      // Negate force directions and transform into body frame
+      const vec3 fb = -1.0 * Rbw * fw.rows(row, col);
+      force_map.emplace(leg_name, fb);
+    }
+
+    row += 3;
+    col += 3;
+  }
+
+  return force_map;
+}
+
+void ConvexMPC::dynamics(const mat& ft_p, const mat& Rwb, double yaw, mat& A,
+                         mat& B) const
+{
+  // Vector from COM to each foot position in world frame
+  mat com_ft_p(3, 4);
+  com_ft_p.col(0) = Rwb * ft_p.col(0);
+  com_ft_p.col(1) = Rwb * ft_p.col(1);
+  com_ft_p.col(2) = Rwb * ft_p.col(2);
+  com_ft_p.col(3) = Rwb * ft_p.col(3);
+
+  // Moment of Interia in world frame
+  const mat Iw = Rwb * Ib_ * Rwb.t();
+  const mat Iw_inv = arma::inv(Iw);
+
+  // Angular velocities map to euler angle rates through the yaw
+  // rotation only for small roll and pitch angles [R2] Eq(10)
+  const mat33 Rz = { { std::cos(yaw), std::sin(yaw), 0.0 },
+                     { -std::sin(yaw), std::cos(yaw), 0.0 },
+                     { 0.0, 0.0, 1.0 } };
+
+  // Continuous time dynamics [R2] Eq(16) and Eq(17)
+  mat Ac(num_states_, num_states_, arma::fill::zeros);
+  Ac.submat(0, 6, 2, 8) = Rz;                // thetadot = Rz * w
+  Ac.submat(3, 9, 5, 11) = eye(3, 3);        // pdot
+  Ac(11, 12) = 1.0;                          // gravity enters zddot
+
+  mat Bc(num_states_, num_controls_, arma::fill::zeros);
+  for (unsigned int i = 0; i < 4; i++)
+  {
+    // wdot = Iw^-1 * (pcom,i x f)
+    Bc.submat(6, i * 3, 8, i * 3 + 2) = Iw_inv * skew_symmetric(com_ft_p.col(i));
+    // pddot = f/m
+    Bc.submat(9, i * 3, 11, i * 3 + 2) = eye(3, 3) / mass_;
+  }
+
+  // First order hold discretization
+  A = eye(num_states_, num_states_) + Ac * dt_;
+  B = Bc * dt_;
+}
+
+mat ConvexMPC::frictionConeConstraint() const
+{
+  // [R1] Eq(7) and Eq(8)
+  // Friction cone constraint per foot
+  const mat Cf = { { 1.0, 0.0, -mu_ },
+                   { 0.0, 1.0, -mu_ },
+                   { 0.0, 1.0, mu_ },
+                   { 1.0, 0.0, mu_ },
+                   { 0.0, 0.0, 1.0 } };
+
+  return Cf;
+}
+
+void ConvexMPC::frictionConeBounds(const GaitMap& gait_map,
+                                   const arma::Mat<unsigned int>& contact_horizon) const
+{
+  const auto upper = 1000000.0;
+  const auto lower = -1000000.0;
+
+  // Friction cone lower and upper limits per foot
+  const vec lbf = { lower, lower, 0.0, 0.0, fzmin_ };
+  const vec ubf = { 0.0, 0.0, upper, upper, fzmax_ };
+
+  // qp_C_ is constant and filled at construction; only the bounds
+  // track the contact schedule here
+  for (unsigned int k = 0; k < horizon_; k++)
+  {
+    for (unsigned int leg = 0; leg < 4; leg++)
+    {
+      const auto row0 = k * num_constraints_ + leg * 5;
+
+      // Predicted contact state for this step when a lookahead table is
+      // provided, otherwise hold the current gait schedule constant
+      const bool stance =
+          (contact_horizon.n_rows > k) ?
+              (contact_horizon(k, leg) == 1) :
+              (gait_map.at(leg_names_.at(leg)).first == LegState::stance);
+
+      if (!stance)
+      {
+        for (unsigned int i = 0; i < 5; i++)
+        {
+          qp_lbC_.at(row0 + i) = 0.0;
+          qp_ubC_.at(row0 + i) = 0.0;
+        }
+      }
+      else
+      {
+        for (unsigned int i = 0; i < 5; i++)
+        {
+          qp_lbC_.at(row0 + i) = lbf(i);
+          qp_ubC_.at(row0 + i) = ubf(i);
+        }
+      }
+    }
+  }
+}
+}  // namespace quadruped_controller
@@ -0,0 +1,179 @@
+/**
+ * @file realtime.cpp
+ * @date 2021-09-25
+ * @author Boston Cleek
+ * @brief Real-time executor utilities
+ */
+
+// Linux
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <cstring>
+#include <cerrno>
+
+#include <ros/console.h>
+
+#include <quadruped_controller/realtime.hpp>
+
+namespace quadruped_controller
+{
+namespace realtime
+{
+static const std::string LOGNAME = "realtime";
+
+/** @brief Hint the CPU that the caller is in a spin-wait loop */
+static void cpu_pause()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#else
+  std::this_thread::yield();
+#endif
+}
+
+TaskPool::TaskPool(unsigned int num_threads)
+{
+  workers_.reserve(num_threads);
+  for (unsigned int i = 0; i < num_threads; i++)
+  {
+    workers_.emplace_back([this] { workerLoop(); });
+  }
+}
+
+TaskPool::~TaskPool()
+{
+  running_.store(false, std::memory_order_relaxed);
+
+  // Bump the generation so spinning workers re-check running_
+  generation_.fetch_add(1, std::memory_order_release);
+
+  for (auto& worker : workers_)
+  {
+    worker.join();
+  }
+}
+
+void TaskPool::run(TaskFn fn, void* context, unsigned int num_tasks)
+{
+  fn_ = fn;
+  context_ = context;
+  num_tasks_ = num_tasks;
+  completed_.store(0, std::memory_order_relaxed);
+
+  // The release store on the claim counter publishes the batch fields:
+  // a claim acquires it, so a worker always sees the batch it claims
+  // into even if it raced in from the previous generation
+  next_task_.store(0, std::memory_order_release);
+  generation_.fetch_add(1, std::memory_order_release);
+
+  // The caller works the batch too
+  drainBatch();
+
+  // Join: every claimed task has finished
+  while (completed_.load(std::memory_order_acquire) != num_tasks)
+  {
+    cpu_pause();
+  }
+}
+
+void TaskPool::drainBatch()
+{
+  while (true)
+  {
+    const auto index = next_task_.fetch_add(1, std::memory_order_acquire);
+    if (index >= num_tasks_)
+    {
+      return;
+    }
+
+    fn_(context_, index);
+    completed_.fetch_add(1, std::memory_order_release);
+  }
+}
+
+void TaskPool::workerLoop()
+{
+  auto seen = generation_.load(std::memory_order_acquire);
+
+  while (running_.load(std::memory_order_relaxed))
+  {
+    // Spin for the next batch, backing off to a yield when idle
+    unsigned int spins = 0;
+    auto current = generation_.load(std::memory_order_acquire);
+    while (current == seen)
+    {
+      if (!running_.load(std::memory_order_relaxed))
+      {
+        return;
+      }
+
+      if (++spins < 1024)
+      {
+        cpu_pause();
+      }
+      else
+      {
+        std::this_thread::yield();
+      }
+
+      current = generation_.load(std::memory_order_acquire);
+    }
+
+    seen = current;
+    drainBatch();
+  }
+}
+
+bool lock_memory()
+{
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+  {
+    ROS_WARN_NAMED(LOGNAME, "Failed to lock memory: %s", std::strerror(errno));
+    return false;
+  }
+
+  ROS_INFO_STREAM_NAMED(LOGNAME, "Locked process memory");
+  return true;
+}
+
+bool set_thread_priority(int priority)
+{
+  sched_param params{};
+  params.sched_priority = priority;
+
+  const auto error =
+      pthread_setschedparam(pthread_self(), SCHED_FIFO, &params);
+
+  if (error != 0)
+  {
+    ROS_WARN_NAMED(LOGNAME, "Failed to set SCHED_FIFO priority %i: %s", priority,
+                   std::strerror(error));
+    return false;
+  }
+
+  ROS_INFO_NAMED(LOGNAME, "Control thread running SCHED_FIFO at priority %i", priority);
+  return true;
+}
+
+bool set_cpu_affinity(int cpu)
+{
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(cpu, &cpu_set);
+
+  const auto error =
+      pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set);
+
+  if (error != 0)
+  {
+    ROS_WARN_NAMED(LOGNAME, "Failed to pin thread to CPU %i: %s", cpu,
+                   std::strerror(error));
+    return false;
+  }
+
+  ROS_INFO_NAMED(LOGNAME, "Control thread pinned to CPU %i", cpu);
+  return true;
+}
+}  // namespace realtime
+}  // namespace quadruped_controller
@@ -0,0 +1,164 @@
+/**
+ * @file state_estimation.cpp
+ * @date 2021-10-23
+ * @author Boston Cleek
+ * @brief Contact-aided state estimation
+ */
+
+// C++
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// ROS
+#include <ros/console.h>
+
+#include <quadruped_controller/state_estimation.hpp>
+
+namespace quadruped_controller
+{
+static const std::string LOGNAME = "state_estimator";
+
+using arma::eye;
+
+StateEstimator::StateEstimator(double sigma_accel, double sigma_foot_velocity,
+                               double sigma_foot_height, double contact_tolerance)
+  : sigma_accel_(sigma_accel)
+  , sigma_foot_velocity_(sigma_foot_velocity)
+  , sigma_foot_height_(sigma_foot_height)
+  , contact_tolerance_(contact_tolerance)
+  , g_({ 0.0, 0.0, -9.81 })
+  , initialized_(false)
+{
+  state_.Rwb.eye();
+  state_.x.zeros();
+  state_.xdot.zeros();
+  state_.w.zeros();
+
+  P_.eye();
+  P_ *= 0.01;
+}
+
+void StateEstimator::initialize(const vec3& x, const vec3& xdot)
+{
+  state_.x = x;
+  state_.xdot = xdot;
+
+  P_.eye();
+  P_ *= 0.01;
+
+  initialized_ = true;
+}
+
+void StateEstimator::update(double dt, const Quaternion& orientation, const vec3& accel,
+                            const vec3& gyro, const JointStatesMap& joint_states_map)
+{
+  if (!initialized_)
+  {
+    ROS_WARN_ONCE_NAMED(LOGNAME, "State estimator used before initialization");
+    initialize(state_.x, state_.xdot);
+  }
+
+  // Orientation and angular velocity come straight from the IMU
+  state_.Rwb = orientation.rotation().matrix();
+  state_.w = state_.Rwb * gyro;
+
+  // Predict: integrate the specific force in world frame
+  const vec3 a_w = state_.Rwb * accel + g_;
+  state_.x += state_.xdot * dt + 0.5 * a_w * (dt * dt);
+  state_.xdot += a_w * dt;
+
+  // P = F*P*F.T + Q with F = [I dt*I; 0 I] and Q = G*G.T*sigma_a^2,
+  // G = [0.5*dt^2*I; dt*I]
+  mat::fixed<6, 6> F(arma::fill::eye);
+  F.submat(0, 3, 2, 5) = dt * eye(3, 3);
+
+  const auto var_accel = sigma_accel_ * sigma_accel_;
+  mat::fixed<6, 6> Q(arma::fill::zeros);
+  Q.submat(0, 0, 2, 2) = 0.25 * std::pow(dt, 4) * var_accel * eye(3, 3);
+  Q.submat(0, 3, 2, 5) = 0.5 * std::pow(dt, 3) * var_accel * eye(3, 3);
+  Q.submat(3, 0, 5, 2) = 0.5 * std::pow(dt, 3) * var_accel * eye(3, 3);
+  Q.submat(3, 3, 5, 5) = dt * dt * var_accel * eye(3, 3);
+
+  P_ = F * P_ * F.t() + Q;
+
+  // Leg odometry (body frame)
+  mat::fixed<3, 4> qs;
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
+  {
+    qs.col(i) = joint_states_map.at(static_cast<LegId>(i)).q;
+  }
+
+  mat::fixed<3, 4> ft_p;
+  kinematics_.forwardKinematicsAll(qs, ft_p);
+
+  std::array<mat33, NUM_LEGS> jacobians;
+  kinematics_.jacobiansAll(qs, jacobians);
+
+  std::array<bool, NUM_LEGS> contacts;
+  detectContacts(ft_p, contacts);
+
+  const mat33 Rv = sigma_foot_velocity_ * sigma_foot_velocity_ * eye(3, 3);
+  const auto var_height = sigma_foot_height_ * sigma_foot_height_;
+
+  // Correct: every foot in contact is stationary in the world frame
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
+  {
+    if (!contacts.at(i))
+    {
+      continue;
+    }
+
+    const vec3 p_f = ft_p.col(i);
+    const vec3 qdot = joint_states_map.at(static_cast<LegId>(i)).qdot;
+
+    // Base velocity seen through a stationary foot, H = [0 I]
+    const vec3 v_meas = -state_.Rwb * (jacobians.at(i) * qdot + arma::cross(gyro, p_f));
+
+    const mat33 S = P_.submat(3, 3, 5, 5) + Rv;
+    const mat::fixed<6, 3> K = P_.cols(3, 5) * arma::inv(S);
+
+    const vec3 innovation = v_meas - state_.xdot;
+    const vec::fixed<6> dx = K * innovation;
+
+    state_.x += dx.rows(0, 2);
+    state_.xdot += dx.rows(3, 5);
+    P_ -= K * P_.rows(3, 5);
+
+    // Base height above a foot on the ground, H = [e3.T 0]
+    const auto z_meas = -arma::dot(state_.Rwb.row(2).t(), p_f);
+
+    const auto s = P_(2, 2) + var_height;
+    const vec::fixed<6> k = P_.col(2) / s;
+
+    const auto residual = z_meas - state_.x(2);
+    state_.x += k.rows(0, 2) * residual;
+    state_.xdot += k.rows(3, 5) * residual;
+    P_ -= k * P_.row(2);
+  }
+}
+
+const RobotStateCoM& StateEstimator::state() const
+{
+  return state_;
+}
+
+void StateEstimator::detectContacts(const mat::fixed<3, 4>& ft_p,
+                                    std::array<bool, NUM_LEGS>& contacts) const
+{
+  // Foot heights in world frame (relative comparison only)
+  double heights[NUM_LEGS];
+  auto z_min = std::numeric_limits<double>::max();
+
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
+  {
+    heights[i] = arma::dot(state_.Rwb.row(2).t(), ft_p.col(i));
+    z_min = std::min(z_min, heights[i]);
+  }
+
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
+  {
+    contacts.at(i) = (heights[i] - z_min) < contact_tolerance_;
+  }
+}
+}  // namespace quadruped_controller
@@ -0,0 +1,122 @@
+/**
+ * @file telemetry.cpp
+ * @date 2021-10-30
+ * @author Boston Cleek
+ * @brief Memory-mapped binary telemetry logging
+ */
+
+// C++
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+
+// Linux
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ROS
+#include <ros/console.h>
+
+#include <quadruped_controller/telemetry.hpp>
+
+namespace quadruped_controller
+{
+namespace telemetry
+{
+static const std::string LOGNAME = "telemetry";
+
+TelemetryLogger::TelemetryLogger(const std::string& path, uint32_t capacity,
+                                 double flush_period)
+  : path_(path)
+  , capacity_(capacity)
+  , flush_period_(flush_period)
+  , map_size_(sizeof(TelemetryFileHeader) + capacity * sizeof(TelemetryRecord))
+  , header_(nullptr)
+  , records_(nullptr)
+  , flushing_(false)
+{
+  static_assert(std::is_trivially_copyable_v<TelemetryRecord>,
+                "telemetry records must be trivially copyable");
+
+  const auto fd = open(path_.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+  if (fd < 0)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Failed to open telemetry log: %s", path_.c_str());
+    return;
+  }
+
+  if (ftruncate(fd, static_cast<off_t>(map_size_)) != 0)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Failed to size telemetry log: %s", path_.c_str());
+    close(fd);
+    return;
+  }
+
+  void* mem = mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (mem == MAP_FAILED)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Failed to map telemetry log: %s", path_.c_str());
+    return;
+  }
+
+  header_ = static_cast<TelemetryFileHeader*>(mem);
+  records_ = reinterpret_cast<TelemetryRecord*>(header_ + 1);
+
+  std::memcpy(header_->magic, TELEMETRY_MAGIC, sizeof(header_->magic));
+  header_->record_size = sizeof(TelemetryRecord);
+  header_->capacity = capacity_;
+  header_->written.store(0, std::memory_order_relaxed);
+
+  flushing_ = true;
+  flush_thread_ = std::thread(&TelemetryLogger::flushLoop, this);
+
+  ROS_INFO_NAMED(LOGNAME, "Logging telemetry to %s (%u record ring)", path_.c_str(),
+                 capacity_);
+}
+
+TelemetryLogger::~TelemetryLogger()
+{
+  if (flushing_)
+  {
+    flushing_ = false;
+    flush_thread_.join();
+  }
+
+  if (header_ != nullptr)
+  {
+    msync(header_, map_size_, MS_SYNC);
+    munmap(header_, map_size_);
+  }
+}
+
+bool TelemetryLogger::valid() const
+{
+  return header_ != nullptr;
+}
+
+void TelemetryLogger::log(const TelemetryRecord& record)
+{
+  const auto written = header_->written.load(std::memory_order_relaxed);
+  std::memcpy(&records_[written % capacity_], &record, sizeof(TelemetryRecord));
+  header_->written.store(written + 1, std::memory_order_release);
+}
+
+void TelemetryLogger::flushLoop()
+{
+  const auto period =
+      std::chrono::duration<double>(flush_period_);
+
+  while (flushing_)
+  {
+    std::this_thread::sleep_for(period);
+
+    // Asynchronous writeback keeps the flusher off the page dirty path
+    msync(header_, map_size_, MS_ASYNC);
+  }
+}
+}  // namespace telemetry
+}  // namespace quadruped_controller
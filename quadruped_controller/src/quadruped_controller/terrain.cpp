@@ -0,0 +1,179 @@
+/**
+ * @file terrain.cpp
+ * @date 2021-11-06
+ * @author Boston Cleek
+ * @brief Terrain heightmap with precomputed foothold index
+ */
+
+// C++
+#include <algorithm>
+#include <cmath>
+
+// ROS
+#include <ros/console.h>
+
+// Quadruped Control
+#include <quadruped_controller/terrain.hpp>
+
+namespace quadruped_controller
+{
+static const std::string LOGNAME = "terrain";
+
+TerrainMap::TerrainMap()
+  : origin_(arma::fill::zeros), resolution_(0.0), rows_(0), cols_(0), cost_max_(0.0)
+{
+}
+
+TerrainMap::TerrainMap(const vec& origin, double resolution, unsigned int rows,
+                       unsigned int cols, double cost_max)
+  : origin_(origin)
+  , resolution_(resolution)
+  , rows_(rows)
+  , cols_(cols)
+  , cost_max_(cost_max)
+  , heights_(rows, cols, arma::fill::zeros)
+  , normals_x_(rows, cols, arma::fill::zeros)
+  , normals_y_(rows, cols, arma::fill::zeros)
+  , normals_z_(rows, cols, arma::fill::ones)
+  , costs_(rows, cols, arma::fill::zeros)
+{
+}
+
+void TerrainMap::update(const mat& heights)
+{
+  if ((heights.n_rows != rows_) || (heights.n_cols != cols_))
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Heightmap update is (%llu x %llu), expected (%u x %u)",
+                    heights.n_rows, heights.n_cols, rows_, cols_);
+    return;
+  }
+
+  heights_ = heights;
+
+  // Surface normals from central differences, one sided at the borders
+  for (unsigned int i = 0; i < rows_; i++)
+  {
+    const auto i0 = (i > 0) ? i - 1 : i;
+    const auto i1 = (i < rows_ - 1) ? i + 1 : i;
+
+    for (unsigned int j = 0; j < cols_; j++)
+    {
+      const auto j0 = (j > 0) ? j - 1 : j;
+      const auto j1 = (j < cols_ - 1) ? j + 1 : j;
+
+      const auto dzdx =
+          (heights_(i1, j) - heights_(i0, j)) / (static_cast<double>(i1 - i0) * resolution_);
+      const auto dzdy =
+          (heights_(i, j1) - heights_(i, j0)) / (static_cast<double>(j1 - j0) * resolution_);
+
+      const vec3 n = arma::normalise(vec3{ -dzdx, -dzdy, 1.0 });
+
+      normals_x_(i, j) = n(0);
+      normals_y_(i, j) = n(1);
+      normals_z_(i, j) = n(2);
+
+      // Flat cells cost 0, vertical faces approach 1
+      costs_(i, j) = 1.0 - n(2);
+    }
+  }
+}
+
+double TerrainMap::height(double x, double y) const
+{
+  unsigned int i = 0;
+  unsigned int j = 0;
+  return cellIndex(x, y, i, j) ? heights_(i, j) : 0.0;
+}
+
+vec3 TerrainMap::normal(double x, double y) const
+{
+  unsigned int i = 0;
+  unsigned int j = 0;
+  if (cellIndex(x, y, i, j))
+  {
+    return { normals_x_(i, j), normals_y_(i, j), normals_z_(i, j) };
+  }
+
+  return { 0.0, 0.0, 1.0 };
+}
+
+double TerrainMap::cost(double x, double y) const
+{
+  unsigned int i = 0;
+  unsigned int j = 0;
+  return cellIndex(x, y, i, j) ? costs_(i, j) : 0.0;
+}
+
+vec3 TerrainMap::snap(const vec3& foothold) const
+{
+  unsigned int i = 0;
+  unsigned int j = 0;
+
+  // Outside the grid (or an empty map) the ground plane is z = 0
+  if (!cellIndex(foothold(0), foothold(1), i, j))
+  {
+    return { foothold(0), foothold(1), 0.0 };
+  }
+
+  if (costs_(i, j) > cost_max_)
+  {
+    // Cheapest cell in a fixed 5x5 neighborhood: bounded-time search
+    auto best_i = i;
+    auto best_j = j;
+    auto best_cost = costs_(i, j);
+
+    const auto i_min = (i > 2) ? i - 2 : 0;
+    const auto j_min = (j > 2) ? j - 2 : 0;
+    const auto i_max = std::min(i + 2, rows_ - 1);
+    const auto j_max = std::min(j + 2, cols_ - 1);
+
+    for (auto ii = i_min; ii <= i_max; ii++)
+    {
+      for (auto jj = j_min; jj <= j_max; jj++)
+      {
+        if (costs_(ii, jj) < best_cost)
+        {
+          best_i = ii;
+          best_j = jj;
+          best_cost = costs_(ii, jj);
+        }
+      }
+    }
+
+    if (best_cost > cost_max_)
+    {
+      ROS_WARN_THROTTLE_NAMED(1.0, LOGNAME,
+                              "No valid foothold near (%.3f, %.3f), best cost: %.3f",
+                              foothold(0), foothold(1), best_cost);
+    }
+
+    // Center of the selected cell
+    return { origin_(0) + static_cast<double>(best_i) * resolution_,
+             origin_(1) + static_cast<double>(best_j) * resolution_,
+             heights_(best_i, best_j) };
+  }
+
+  return { foothold(0), foothold(1), heights_(i, j) };
+}
+
+bool TerrainMap::cellIndex(double x, double y, unsigned int& i, unsigned int& j) const
+{
+  if (rows_ == 0 || cols_ == 0)
+  {
+    return false;
+  }
+
+  const auto di = std::floor((x - origin_(0)) / resolution_ + 0.5);
+  const auto dj = std::floor((y - origin_(1)) / resolution_ + 0.5);
+
+  if (di < 0.0 || dj < 0.0 || di >= static_cast<double>(rows_) ||
+      dj >= static_cast<double>(cols_))
+  {
+    return false;
+  }
+
+  i = static_cast<unsigned int>(di);
+  j = static_cast<unsigned int>(dj);
+  return true;
+}
+}  // namespace quadruped_controller
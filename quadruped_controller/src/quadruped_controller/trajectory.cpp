@@ -68,81 +68,237 @@ Pose integrate_twist_yaw(const Pose& pose, const vec& u, double dt)
   return Pose(Twbp);
 }
 
+/////////////////////////////////////////////////////////
+// BaseTrajectory
+BaseTrajectory::BaseTrajectory(double dt, double linear_accel_max,
+                               double angular_accel_max, double filter_cutoff)
+  : dt_(dt)
+  , linear_accel_max_(linear_accel_max)
+  , angular_accel_max_(angular_accel_max)
+  , alpha_(1.0 - std::exp(-2.0 * M_PI * filter_cutoff * dt))
+{
+  Rwb_d_.eye();
+  x_d_.zeros();
+  xdot_d_.zeros();
+  w_d_.zeros();
+}
+
+void BaseTrajectory::reset(const vec3& x, double yaw, double height)
+{
+  vx_ = 0.0;
+  vy_ = 0.0;
+  wz_ = 0.0;
+
+  yaw_ = yaw;
+  height_ = height;
+
+  x_d_ = x;
+  x_d_(2) = height_;
+  xdot_d_.zeros();
+  w_d_.zeros();
+
+  updateRotation();
+}
+
+void BaseTrajectory::advance(const vec::fixed<6>& vb_cmd)
+{
+  // First-order shaping toward the command with the step clamped to the
+  // acceleration limits - large command jumps become smooth ramps
+  const auto shape = [this](double reference, double command, double accel_max) {
+    const auto delta_max = accel_max * dt_;
+    return reference + std::clamp(alpha_ * (command - reference), -delta_max, delta_max);
+  };
+
+  vx_ = shape(vx_, vb_cmd(0), linear_accel_max_);
+  vy_ = shape(vy_, vb_cmd(1), linear_accel_max_);
+  wz_ = shape(wz_, vb_cmd(5), angular_accel_max_);
+
+  // Integrate the pose from the cached yaw: the rotation is yaw only so
+  // rotating the body velocity into world is two products per axis
+  yaw_ += wz_ * dt_;
+  updateRotation();
+
+  xdot_d_(0) = Rwb_d_(0, 0) * vx_ + Rwb_d_(0, 1) * vy_;
+  xdot_d_(1) = Rwb_d_(1, 0) * vx_ + Rwb_d_(1, 1) * vy_;
+
+  x_d_(0) += xdot_d_(0) * dt_;
+  x_d_(1) += xdot_d_(1) * dt_;
+  x_d_(2) = height_;  // pinned so the reference height cannot drift
+
+  w_d_(2) = wz_;
+}
+
+const mat33& BaseTrajectory::rotation() const
+{
+  return Rwb_d_;
+}
+
+const vec3& BaseTrajectory::position() const
+{
+  return x_d_;
+}
+
+const vec3& BaseTrajectory::linearVelocity() const
+{
+  return xdot_d_;
+}
+
+const vec3& BaseTrajectory::angularVelocity() const
+{
+  return w_d_;
+}
+
+void BaseTrajectory::sampleHorizon(double dt, unsigned int steps, vec& x_ref) const
+{
+  // One MPC state [theta, p, w, pdot, g] per step
+  const unsigned int num_states = 13;
+  if (x_ref.n_elem != num_states * steps)
+  {
+    x_ref.set_size(num_states * steps);
+  }
+
+  auto yaw = yaw_;
+  vec3 p = x_d_;
+
+  for (unsigned int k = 0; k < steps; k++)
+  {
+    yaw += wz_ * dt;
+    const auto cyaw = cos(yaw);
+    const auto syaw = sin(yaw);
+
+    const auto xdot = cyaw * vx_ - syaw * vy_;
+    const auto ydot = syaw * vx_ + cyaw * vy_;
+
+    p(0) += xdot * dt;
+    p(1) += ydot * dt;
+
+    const auto row = k * num_states;
+    x_ref(row) = 0.0;
+    x_ref(row + 1) = 0.0;
+    x_ref(row + 2) = yaw;
+
+    x_ref(row + 3) = p(0);
+    x_ref(row + 4) = p(1);
+    x_ref(row + 5) = height_;
+
+    x_ref(row + 6) = 0.0;
+    x_ref(row + 7) = 0.0;
+    x_ref(row + 8) = wz_;
+
+    x_ref(row + 9) = xdot;
+    x_ref(row + 10) = ydot;
+    x_ref(row + 11) = 0.0;
+
+    x_ref(row + 12) = -9.81;
+  }
+}
+
+void BaseTrajectory::updateRotation()
+{
+  const auto cyaw = cos(yaw_);
+  const auto syaw = sin(yaw_);
+
+  Rwb_d_(0, 0) = cyaw;
+  Rwb_d_(0, 1) = -syaw;
+  Rwb_d_(0, 2) = 0.0;
+
+  Rwb_d_(1, 0) = syaw;
+  Rwb_d_(1, 1) = cyaw;
+  Rwb_d_(1, 2) = 0.0;
+
+  Rwb_d_(2, 0) = 0.0;
+  Rwb_d_(2, 1) = 0.0;
+  Rwb_d_(2, 2) = 1.0;
+}
+
 /////////////////////////////////////////////////////////
 // SupportPolygon
 SupportPolygon::SupportPolygon()
 {
-  adjacent_leg_map_.emplace("RL", std::make_pair("FL", "RR"));
-  adjacent_leg_map_.emplace("FL", std::make_pair("FR", "RL"));
-  adjacent_leg_map_.emplace("FR", std::make_pair("RR", "FL"));
-  adjacent_leg_map_.emplace("RR", std::make_pair("RL", "FR"));
+  // Adjacency over the canonical leg order [RL FL RR FR]
+  clockwise_.at(LegId::RL) = LegId::FL;
+  clockwise_.at(LegId::FL) = LegId::FR;
+  clockwise_.at(LegId::FR) = LegId::RR;
+  clockwise_.at(LegId::RR) = LegId::RL;
+
+  counter_clockwise_.at(LegId::RL) = LegId::RR;
+  counter_clockwise_.at(LegId::FL) = LegId::RL;
+  counter_clockwise_.at(LegId::FR) = LegId::FL;
+  counter_clockwise_.at(LegId::RR) = LegId::FR;
 }
 
-vec SupportPolygon::position(const ScheduledPhasesMap& phase_map,
-                             const FootholdMap& foot_map, const GaitMap& gait_map) const
+void SupportPolygon::position(const ScheduledPhasesMap& phase_map,
+                              const FootholdMap& foot_map, const GaitMap& gait_map,
+                              vec& zeta) const
 {
-  // map leg name -> total weight for foot
-  std::map<std::string, double> weight_map;
-
   // constant and
   const auto root2 = std::sqrt(2.0);
 
-  // Compose weights
-  for (const auto& [leg_name, adjacent_legs] : adjacent_leg_map_)
+  // total weight per foot indexed by LegId
+  std::array<double, NUM_LEGS> weights;
+
+  // Compose weights - the stance and swing formulas share one shape so
+  // the contact state only selects the sign, offset, and phase bounds
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
   {
-    const auto phase = gait_map.at(leg_name).second;
+    const auto id = static_cast<LegId>(i);
+    const auto phase = gait_map.at(id).second;
+    const auto& phases = phase_map.at(id);
+
+    const bool in_stance = (gait_map.at(id).first == LegState::stance);
+    const auto sign = in_stance ? 1.0 : -1.0;
+    const auto offset = in_stance ? 0.0 : 2.0;
+    const auto sigma_0 = in_stance ? phases.stance_start : phases.swing_start;
+    const auto sigma_f = in_stance ? phases.stance_end : phases.swing_end;
+
+    // add epsilon to prevent division by 0
+    weights.at(i) = 0.5 * (offset + std::erf(sign * phase / (sigma_0 * root2 + 1.0e-12)) +
+                           std::erf(sign * (1.0 - phase) / (sigma_f * root2 + 1.0e-12)));
+  }
 
-    auto weight = 0.0;
-    if (gait_map.at(leg_name).first == LegState::stance)
-    {
-      const auto c0 = phase_map.at(leg_name).stance_start;
-      const auto cf = phase_map.at(leg_name).stance_end;
+  // Compose virtual points for all legs, accumulating the x,y averages
+  auto zeta_x = 0.0;
+  auto zeta_y = 0.0;
 
-      // add epsilon to prevent division by 0
-      weight = 0.5 * (std::erf(phase / (c0 * root2 + 1.0e-12)) +
-                      std::erf((1.0 - phase) / (cf * root2 + 1.0e-12)));
-    }
-    else
-    {
-      const auto s0 = phase_map.at(leg_name).swing_start;
-      const auto sf = phase_map.at(leg_name).swing_end;
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
+  {
+    const auto id = static_cast<LegId>(i);
+    const auto weight = weights.at(i);
 
-      // add epsilon to prevent division by 0
-      weight = 0.5 * (2.0 + std::erf(-phase / (s0 * root2 + 1.0e-12)) +
-                      std::erf((phase - 1.0) / (sf * root2 + 1.0e-12)));
-    }
+    // Only use x,y positions of the foot and its clockwise and counter
+    // clockwise neighbors
+    const vec3& p = foot_map.at(id);
+    const vec3& p_minus = foot_map.at(clockwise_.at(i));
+    const vec3& p_plus = foot_map.at(counter_clockwise_.at(i));
+
+    const auto zeta_minus_x = p(0) * weight + p_minus(0) * (1.0 - weight);
+    const auto zeta_minus_y = p(1) * weight + p_minus(1) * (1.0 - weight);
 
-    weight_map.emplace(leg_name, weight);
+    const auto zeta_plus_x = p(0) * weight + p_plus(0) * (1.0 - weight);
+    const auto zeta_plus_y = p(1) * weight + p_plus(1) * (1.0 - weight);
+
+    const auto w_minus = weights.at(clockwise_.at(i));
+    const auto w_plus = weights.at(counter_clockwise_.at(i));
+
+    const auto scale = 1.0 / (weight + w_minus + w_plus);
+    zeta_x += scale * (weight * p(0) + w_minus * zeta_minus_x + w_plus * zeta_plus_x);
+    zeta_y += scale * (weight * p(1) + w_minus * zeta_minus_y + w_plus * zeta_plus_y);
   }
 
-  mat supports(2, 4);
-  unsigned int i = 0;
-  // Compose virtual points for all legs
-  for (const auto& [leg_name, weight] : weight_map)
+  if (zeta.n_elem != 2)
   {
-    // Only use x,y positions
-    // foot position
-    const vec p = foot_map.at(leg_name).rows(0, 1);
-    // clockwise foot position
-    const vec p_minus = foot_map.at(adjacent_leg_map_.at(leg_name).first).rows(0, 1);
-    // counter clockwise foot position
-    const vec p_plus = foot_map.at(adjacent_leg_map_.at(leg_name).second).rows(0, 1);
-
-    const vec zeta_minus = p * weight + p_minus * (1.0 - weight);
-    const vec zeta_plus = p * weight + p_plus * (1.0 - weight);
-
-    const auto w_minus = weight_map.at(adjacent_leg_map_.at(leg_name).first);
-    const auto w_plus = weight_map.at(adjacent_leg_map_.at(leg_name).second);
-
-    supports.col(i) = (1.0 / (weight + w_minus + w_plus)) *
-                      (weight * p + w_minus * zeta_minus + w_plus * zeta_plus);
-    i++;
+    zeta.set_size(2);
   }
 
-  vec zeta(2);
-  zeta.row(0) = arma::sum(supports.row(0)) / 4.0;
-  zeta.row(1) = arma::sum(supports.row(1)) / 4.0;
+  zeta(0) = zeta_x / static_cast<double>(NUM_LEGS);
+  zeta(1) = zeta_y / static_cast<double>(NUM_LEGS);
+}
 
+vec SupportPolygon::position(const ScheduledPhasesMap& phase_map,
+                             const FootholdMap& foot_map, const GaitMap& gait_map) const
+{
+  vec zeta(2);
+  position(phase_map, foot_map, gait_map, zeta);
   return zeta;
 }
 
@@ -212,16 +368,48 @@ vec SupportPolygon::position(const ScheduledPhasesMap& phase_map,
 
 /////////////////////////////////////////////////////////
 // FootTrajectory
-FootTrajectory::FootTrajectory()
-  : A_(initSystem()), coefficients_(7, 3, arma::fill::zeros)
+
+/**
+ * @brief Inverse of the boundary condition system, factored once
+ * @return inverse system (7x7)
+ * @details The system A is a compile-time constant on t:[0, 1].
+ * position: s(t) = a0 + a1*t + a2*t^2 + a3*t^3 + a4*t^4 + a5*t^5 + a6*t^6
+ * linear velocity; sdot(t) = a1 + 2*a2*t + 3*a3*t^2 + 4*a4*t^3 + 5*a5*t^4 + 6*a6*t^5
+ * linear acceleration sddot(t) = 2*a2 + 6*a3*t + 12*a4*t^2 + 20*a5*t^3 + 30*a6*t^4
+ * constraints:
+ * positions (start, final, center) s(0) = p0, s(1) = pf, s(0.5) = pc
+ * linear velocities: sdot(0) = sdot(1) = 0
+ * linear accelerations sddot(0) = sddot(1) = 0
+ * The inverse is computed on first use and shared by every trajectory so
+ * replanning is a 7x3 multiply with no factorization.
+ */
+static const mat::fixed<7, 7>& inverseSystem()
+{
+  static const mat::fixed<7, 7> Ainv = []() {
+    const mat A = { { 1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 },
+                    { 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0 },
+                    { 1.0, 0.5, pow(0.5, 2), pow(0.5, 3), pow(0.5, 4), pow(0.5, 5),
+                      pow(0.5, 6) },
+                    { 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 0.0 },
+                    { 0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0 },
+                    { 0.0, 0.0, 2.0, 0.0, 0.0, 0.0, 0.0 },
+                    { 0.0, 0.0, 2.0, 6.0, 12.0, 20.0, 30.0 } };
+
+    return mat::fixed<7, 7>(arma::inv(A));
+  }();
+
+  return Ainv;
+}
+
+FootTrajectory::FootTrajectory() : coefficients_(arma::fill::zeros)
 {
 }
 
 bool FootTrajectory::generateTrajetory(const vec3& p_start, const vec3& p_center,
                                        const vec3& p_final) const
 {
-  const mat B = constantTerms(p_start, p_center, p_final);
-  return arma::solve(coefficients_, A_, B, arma::solve_opts::fast);
+  coefficients_ = inverseSystem() * constantTerms(p_start, p_center, p_final);
+  return coefficients_.is_finite();
 }
 
 FootState FootTrajectory::trackTrajectory(double t) const
@@ -231,53 +419,23 @@ FootState FootTrajectory::trackTrajectory(double t) const
     throw std::invalid_argument("t must be on domain [0 1]");
   }
 
-  // s(t)
-  const vec position_factors = { 1.0,       t,         pow(t, 2), pow(t, 3),
-                                 pow(t, 4), pow(t, 5), pow(t, 6) };
-
-  // sdot(t)
-  const vec velocity_factors = {
-    0.0, 1.0, 2.0 * t, 3.0 * pow(t, 2), 4.0 * pow(t, 3), 5.0 * pow(t, 4), 6.0 * pow(t, 5)
-  };
-
-  const vec3 p_ref = (position_factors.t() * coefficients_).t();
-  const vec3 v_ref = (velocity_factors.t() * coefficients_).t();
+  // Horner evaluation sharing the time basis across x, y, and z
+  vec3 p_ref = coefficients_.row(6).t();
+  vec3 v_ref = 6.0 * coefficients_.row(6).t();
 
-  // const vec accel_factors = {
-  //   0.0, 0.0, 2.0, 6.0 * t, 12.0 * pow(t, 2), 20.0 * pow(t, 3), 30.0 * pow(t, 3)
-  // };
+  for (unsigned int i = 6; i-- > 1;)
+  {
+    p_ref = p_ref * t + coefficients_.row(i).t();
+    v_ref = v_ref * t + static_cast<double>(i) * coefficients_.row(i).t();
+  }
 
-  // const vec3 a_ref = (accel_factors.t() * coefficients_).t();
-  // a_ref.print("a_ref");
+  p_ref = p_ref * t + coefficients_.row(0).t();
 
   return FootState(p_ref, v_ref);
 }
 
-mat FootTrajectory::initSystem() const
-{
-  // t:[0, 1]
-  // position: s(t) = a0 + a1*t + a2*t^2 + a3*t^3 + a4*t^4 + a5*t^5 + a6*t^6
-  // linear velocity; sdot(t) = a1 + 2*a2*t + 3*a3*t^2 + 4*a4*t^3 + 5*a5*t^4 + 6*a6*t^5
-  // linear acceleration sddot(t) = 2*a2 + 6*a3*t + 12*a4*t^2 + 20*a5*t^3 + 30*a6*t^4
-  // constraints:
-  // positions (start, final, center) s(0) = p0, s(1) = pf, s(0.5) = pc
-  // linear velocities: sdot(0) = sdot(1) = 0
-  // linear accelerations sddot(0) = sddot(1) = 0
-
-  const mat A = { { 1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 },
-                  { 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0 },
-                  { 1.0, 0.5, pow(0.5, 2), pow(0.5, 3), pow(0.5, 4), pow(0.5, 5),
-                    pow(0.5, 6) },
-                  { 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 0.0 },
-                  { 0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0 },
-                  { 0.0, 0.0, 2.0, 0.0, 0.0, 0.0, 0.0 },
-                  { 0.0, 0.0, 2.0, 6.0, 12.0, 20.0, 30.0 } };
-
-  return A;
-}
-
-mat FootTrajectory::constantTerms(const vec3& p_start, const vec3& p_center,
-                                  const vec3& p_final) const
+mat::fixed<7, 3> FootTrajectory::constantTerms(const vec3& p_start, const vec3& p_center,
+                                               const vec3& p_final) const
 {
   // Trajectory constraints
   // [x0  y0  z0] = p0
@@ -287,7 +445,7 @@ mat FootTrajectory::constantTerms(const vec3& p_start, const vec3& p_center,
   // [vxf vyf vzf] = 0
   // [ax0 ay0 az0] = 0
   // [axf ayf azf] = 0
-  mat B(7, 3, arma::fill::zeros);
+  mat::fixed<7, 3> B(arma::fill::zeros);
   B.row(0) = p_start.t();
   B.row(1) = p_final.t();
   B.row(2) = p_center.t();
@@ -0,0 +1,324 @@
+/**
+ * @file replay_commander.cpp
+ * @date 2021-11-27
+ * @author Boston Cleek
+ * @brief Replay a captured input stream through the commander pipeline
+ *
+ * @details Feeds joint states, COM states, and twist commands from a
+ * capture file (see capture.hpp) through the same control pipeline the
+ * commander runs live: gait schedule, foothold planning, swing
+ * trajectories and IK, balance QP, and jacobian transpose control.
+ * Time comes from the recorded stamps instead of the wall clock, so a
+ * replay is deterministic - the same file produces bit-identical torque
+ * outputs run to run - and finishes as fast as the solver allows.
+ * Controller gains mirror mit_cheetah_config.yaml.
+ *
+ * Emits one CSV row per control tick: stamp_ns, 12 joint torques in
+ * actuator order [RL FL RR FR] x [hip, thigh, calf], and the
+ * consecutive QP failure count.
+ *
+ * Usage: replay_commander <capture_file> [output_csv] [frequency]
+ */
+
+// C++
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// Quadruped Control
+#include <quadruped_controller/balance_controller.hpp>
+#include <quadruped_controller/capture.hpp>
+#include <quadruped_controller/foot_planner.hpp>
+#include <quadruped_controller/gait.hpp>
+#include <quadruped_controller/joint_controller.hpp>
+#include <quadruped_controller/kinematics.hpp>
+#include <quadruped_controller/static_kinematics.hpp>
+#include <quadruped_controller/trajectory.hpp>
+#include <quadruped_controller/math/numerics.hpp>
+
+using arma::mat;
+using arma::vec;
+using arma::vec3;
+
+using namespace quadruped_controller;
+using namespace math;
+
+static const std::vector<std::string> leg_names = { "RL", "FL", "RR", "FR" };
+
+/** @brief Gait schedule at a gait time from the closed-form phase equations */
+static GaitMap gaitAtTime(double t, double t_stance, double t_swing, const vec& offset)
+{
+  const auto period = t_stance + t_swing;
+  const auto stance_phase = t_stance / period;
+
+  GaitMap gait_map;
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
+  {
+    // wrap phase [0 1)
+    const auto phase = std::fmod(offset(i) + t / period, 1.0);
+    const auto state = (phase <= stance_phase) ? LegState::stance : LegState::swing;
+    gait_map.emplace(static_cast<LegId>(i), std::make_pair(state, phase));
+  }
+
+  return gait_map;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    std::cerr << "Usage: replay_commander <capture_file> [output_csv] [frequency]"
+              << std::endl;
+    return 1;
+  }
+
+  std::vector<capture::InputRecord> records;
+  if (!capture::loadCapture(argv[1], records) || records.empty())
+  {
+    std::cerr << "Failed to load capture: " << argv[1] << std::endl;
+    return 1;
+  }
+
+  std::ofstream file;
+  if (argc > 2)
+  {
+    file.open(argv[2]);
+    if (!file.is_open())
+    {
+      std::cerr << "Failed to open output: " << argv[2] << std::endl;
+      return 1;
+    }
+  }
+
+  std::ostream& out = file.is_open() ? file : std::cout;
+
+  auto frequency = 300.0;
+  if (argc > 3)
+  {
+    frequency = std::stod(argv[3]);
+  }
+
+  // Gait and swing leg trajectory (mit_cheetah_config.yaml)
+  const auto t_stance = 0.8;
+  const auto t_swing = 0.18;
+  const auto foot_height = 0.08;
+  const vec phase_offset = { 0.0, 0.5, 0.5, 0.0 };  // [RL FL RR FR]
+
+  // Dynamics
+  const auto mu = 0.8;
+  const auto mass = 11.0;
+  const auto fzmin = 10.0;
+  const auto fzmax = 120.0;
+  const mat Ib = arma::diagmat(vec{ 0.011253, 0.036203, 0.042673 });
+
+  // Balance controller gains
+  const mat S = arma::diagmat(vec{ 1.0, 1.0, 1.0, 10.0, 10.0, 5.0 });
+  const mat W = arma::eye(12, 12) * 1e-5;
+  const vec kff = { 0.0, 0.0, 0.15, 0.0, 0.0, 0.0 };
+  const vec kp_p = { 100.0, 100.0, 100.0 };
+  const vec kd_p = { 50.0, 50.0, 50.0 };
+  const vec kp_w = { 5000.0, 5000.0, 5000.0 };
+  const vec kd_w = { 500.0, 500.0, 500.0 };
+
+  // Swing leg joint PD gains
+  const vec jc_kff = { 0.0, 0.0, 0.0 };
+  const vec jc_kp = { 40.0, 40.0, 50.0 };
+  const vec jc_kd = { 1.0, 1.0, 1.0 };
+
+  // Torque limits and standing height
+  const auto tau_min = -20.0;
+  const auto tau_max = 20.0;
+  const auto standing_height = 0.26;
+
+  const BalanceController balance_controller(mu, mass, fzmin, fzmax, Ib, S, W, kff,
+                                             kp_p, kd_p, kp_w, kd_w, leg_names);
+  const JointController joint_controller(jc_kff, jc_kp, jc_kd);
+  const QuadrupedKinematics kinematics;
+  const FootPlanner foothold_planner;
+  const FootTrajectoryManager foot_traj_manager(foot_height, t_swing, t_stance);
+
+  // Latest input snapshots, stand in for the commander's state buffers
+  JointStatesMap joint_states_map;
+  for (const auto& leg_name : leg_names)
+  {
+    joint_states_map.emplace(leg_name, LegJointStates());
+  }
+
+  RobotStateCoM com_state;
+  com_state.x.zeros();
+  com_state.xdot.zeros();
+  com_state.w.zeros();
+  com_state.Rwb.eye();
+
+  arma::vec::fixed<6> Vb(arma::fill::zeros);
+  auto cmd_vel_received = false;
+
+  // Desired COM state starts at the standing configuration
+  mat Rwb_d = arma::eye(3, 3);
+  vec3 x_d = { 0.0, 0.0, standing_height };
+  vec3 xdot_d(arma::fill::zeros);
+  vec3 w_d(arma::fill::zeros);
+
+  GaitMap gait_map = make_stance_gait();
+
+  auto standing = false;
+  auto gait_running = false;
+  auto gait_start = 0.0;
+
+  const auto dt = 1.0 / frequency;
+  const auto t_start = static_cast<double>(records.front().stamp_ns) * 1e-9;
+  const auto t_end = static_cast<double>(records.back().stamp_ns) * 1e-9;
+
+  out << "stamp_ns";
+  for (const auto& leg_name : leg_names)
+  {
+    out << "," << leg_name << "_hip," << leg_name << "_thigh," << leg_name << "_calf";
+  }
+  out << ",qp_failures" << std::endl;
+
+  size_t next_record = 0;
+  auto t = 0.0;
+  while (t_start + t <= t_end)
+  {
+    // Apply every input recorded up to this tick, newest snapshot wins
+    // exactly as it does in the live state buffers
+    const auto tick_ns = static_cast<uint64_t>(t_start * 1e9) +
+                         static_cast<uint64_t>(t * 1e9);
+
+    while (next_record < records.size() && records.at(next_record).stamp_ns <= tick_ns)
+    {
+      const capture::InputRecord& record = records.at(next_record);
+
+      if (record.type == capture::joint_states)
+      {
+        joint_states_map = capture::unpackJointStates(record);
+      }
+      else if (record.type == capture::com_state)
+      {
+        com_state = capture::unpackComState(record);
+      }
+      else if (record.type == capture::cmd_vel)
+      {
+        Vb = capture::unpackCmdVel(record);
+        cmd_vel_received = true;
+      }
+
+      next_record++;
+    }
+
+    const mat33& Rwb = com_state.Rwb;
+    const vec3& x = com_state.x;
+    const vec3& xdot = com_state.xdot;
+    const vec3& w = com_state.w;
+
+    // FK (body frame)
+    const FootholdMap foot_actual_map = kinematics.forwardKinematics(joint_states_map);
+
+    // Standing height achieved: start the gait
+    if (!standing && math::almost_equal(x(2), standing_height, 0.005))
+    {
+      standing = true;
+      gait_running = true;
+      gait_start = t;
+    }
+
+    if (gait_running)
+    {
+      if (cmd_vel_received)
+      {
+        // Integrate the commanded twist, same as the commander loop
+        const Pose pose(Rwb, x);
+        const Pose pose_desired = integrate_twist_yaw(pose, Vb, dt);
+
+        Rwb_d = pose_desired.orientation.matrix();
+        x_d = pose_desired.position;
+        x_d(2) = standing_height;
+
+        const vec Vw = pose.transform().adjoint() * Vb;
+        xdot_d = Vw.rows(0, 2);
+        w_d = Vw.rows(3, 5);
+      }
+
+      // Gait phases follow the recorded time line
+      gait_map = gaitAtTime(t - gait_start, t_stance, t_swing, phase_offset);
+
+      // Plan footholds (world frame) for legs entering swing
+      const auto foothold_plan = foothold_planner.positions(t_stance, Rwb, x, xdot, w,
+                                                            xdot_d, foot_actual_map,
+                                                            gait_map);
+
+      if (std::get<bool>(foothold_plan))
+      {
+        const FootholdMap foothold_final_map = std::get<FootholdMap>(foothold_plan);
+
+        FootTrajBoundsMap foot_traj_bounds_map;
+        for (const auto& [leg_name, p_final] : foothold_final_map)
+        {
+          const vec3 p_start = Rwb * foot_actual_map.at(leg_name) + x;
+          foot_traj_bounds_map.emplace(leg_name, FootTrajBounds(p_start, p_final));
+        }
+
+        foot_traj_manager.referenceStates(gait_map, foot_traj_bounds_map);
+      }
+      else
+      {
+        foot_traj_manager.referenceStates(gait_map);
+      }
+    }
+
+    // Swing leg reference joint states
+    JointStatesMap swing_leg_js_map;
+    for (const auto& [leg_name, leg_state] : gait_map)
+    {
+      if (leg_state.first == LegState::swing)
+      {
+        FootState foot_state =
+            foot_traj_manager.referenceState(leg_name, gait_map.at(leg_name).second);
+
+        // Transform foot state into body frame for IK and J^-1
+        foot_state.position = Rwb.t() * foot_state.position - x;
+        foot_state.velocity = Rwb.t() * foot_state.velocity;
+
+        const vec3 q =
+            RobotKinematics::legInverseKinematics(leg_id(leg_name), foot_state.position);
+        const vec3 qdot =
+            RobotKinematics::legJacobianInverse(leg_id(leg_name), q) * foot_state.velocity;
+
+        swing_leg_js_map.emplace(leg_name, LegJointStates(q, qdot));
+      }
+    }
+
+    // Leg swing control
+    const TorqueMap swing_torque_map =
+        joint_controller.control(swing_leg_js_map, joint_states_map);
+
+    // Optimize GRF for stance legs
+    const ForceMap force_map = balance_controller.control(Rwb, Rwb_d, x, xdot, w, x_d,
+                                                          xdot_d, w_d, foot_actual_map,
+                                                          gait_map);
+
+    // Only use for stance legs
+    TorqueMap torque_map = kinematics.jacobianTransposeControl(joint_states_map, force_map);
+
+    // Merge torque maps
+    torque_map.insert(swing_torque_map.begin(), swing_torque_map.end());
+
+    // One row per tick in actuator order [RL FL RR FR]
+    out << tick_ns;
+    for (const auto& leg_name : leg_names)
+    {
+      vec3 tau(arma::fill::zeros);
+      if (torque_map.contains(leg_name))
+      {
+        tau = arma::clamp(torque_map.at(leg_name), tau_min, tau_max);
+      }
+
+      out << "," << tau(0) << "," << tau(1) << "," << tau(2);
+    }
+    out << "," << balance_controller.consecutiveFailures() << "\n";
+
+    t += dt;
+  }
+
+  return 0;
+}
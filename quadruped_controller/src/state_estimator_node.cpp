@@ -0,0 +1,165 @@
+/**
+ * @file state_estimator_node.cpp
+ * @author Boston Cleek
+ * @date 2021-10-23
+ * @brief Contact-aided COM state estimation
+ *
+ * @PARAMETERS:
+ *
+ * @PUBLISHES:
+ *    com_state (quadruped_msgs/CoMState) - estimated COM pose and velocity twist
+ * @SUBSCRIBES:
+ *    imu (sensor_msgs/Imu) - base orientation, angular velocity, and acceleration
+ *    joint_states (sensor_msgs/JointState) - joint names, positions, and velocities
+ */
+
+// C++
+#include <algorithm>
+#include <atomic>
+
+// ROS
+#include <ros/ros.h>
+#include <sensor_msgs/Imu.h>
+#include <sensor_msgs/JointState.h>
+
+// Quadruped Control
+#include <quadruped_controller/realtime.hpp>
+#include <quadruped_controller/state_estimation.hpp>
+#include <quadruped_msgs/CoMState.h>
+
+using arma::vec3;
+
+using namespace quadruped_controller;
+
+const static std::string LOGNAME = "state_estimator";
+
+static std::atomic_bool imu_received = false;
+
+/** @brief IMU sample snapshot */
+struct ImuSample
+{
+  double orientation[4] = { 1.0, 0.0, 0.0, 0.0 };  // [qw, qx, qy, qz]
+  double accel[3] = { 0.0, 0.0, 0.0 };             // specific force (m/s^2)
+  double gyro[3] = { 0.0, 0.0, 0.0 };              // angular velocity (rad/s)
+};
+
+// Latest IMU sample for the joint states callback
+static realtime::StateBuffer<ImuSample> imu_buffer{ ImuSample() };
+
+void imuCallback(const sensor_msgs::Imu::ConstPtr& msg)
+{
+  ImuSample sample;
+  sample.orientation[0] = msg->orientation.w;
+  sample.orientation[1] = msg->orientation.x;
+  sample.orientation[2] = msg->orientation.y;
+  sample.orientation[3] = msg->orientation.z;
+
+  sample.accel[0] = msg->linear_acceleration.x;
+  sample.accel[1] = msg->linear_acceleration.y;
+  sample.accel[2] = msg->linear_acceleration.z;
+
+  sample.gyro[0] = msg->angular_velocity.x;
+  sample.gyro[1] = msg->angular_velocity.y;
+  sample.gyro[2] = msg->angular_velocity.z;
+
+  imu_buffer.write(sample);
+  imu_received = true;
+}
+
+int main(int argc, char** argv)
+{
+  ROS_INFO_STREAM_NAMED(LOGNAME, "Starting state estimator node");
+  ros::init(argc, argv, "state_estimator");
+  ros::NodeHandle nh;
+  ros::NodeHandle pnh("~");
+
+  ros::Publisher com_pub = nh.advertise<quadruped_msgs::CoMState>("com_state", 1);
+
+  // Filter noise and contact detection configuration
+  const auto sigma_accel = pnh.param<double>("estimation/sigma_accel", 0.5);
+  const auto sigma_foot_velocity =
+      pnh.param<double>("estimation/sigma_foot_velocity", 0.05);
+  const auto sigma_foot_height = pnh.param<double>("estimation/sigma_foot_height", 0.01);
+  const auto contact_tolerance =
+      pnh.param<double>("estimation/contact_tolerance", 0.02);
+
+  std::vector<double> initial_position = { 0.0, 0.0, 0.06 };
+  pnh.getParam("estimation/initial_position", initial_position);
+
+  StateEstimator estimator(sigma_accel, sigma_foot_velocity, sigma_foot_height,
+                           contact_tolerance);
+  estimator.initialize(vec3(initial_position), vec3(arma::fill::zeros));
+
+  ros::Time last_stamp;
+
+  // Update and publish at the joint states rate so the balance
+  // controller never waits on state
+  boost::function<void(const sensor_msgs::JointState::ConstPtr&)> jointCallback =
+      [&](const sensor_msgs::JointState::ConstPtr& msg) {
+        if (!imu_received)
+        {
+          return;
+        }
+
+        // Follows joint_state topic format: hips, thighs, calfs by leg
+        JointStatesMap joint_states_map;
+        for (unsigned int i = 0; i < NUM_LEGS; i++)
+        {
+          LegJointStates leg;
+          leg.q = { msg->position.at(i), msg->position.at(i + 4),
+                    msg->position.at(i + 8) };
+          leg.qdot = { msg->velocity.at(i), msg->velocity.at(i + 4),
+                       msg->velocity.at(i + 8) };
+
+          joint_states_map.emplace(static_cast<LegId>(i), leg);
+        }
+
+        const ImuSample sample = imu_buffer.read();
+        const math::Quaternion orientation(sample.orientation[0], sample.orientation[1],
+                                           sample.orientation[2], sample.orientation[3]);
+
+        const vec3 accel = { sample.accel[0], sample.accel[1], sample.accel[2] };
+        const vec3 gyro = { sample.gyro[0], sample.gyro[1], sample.gyro[2] };
+
+        // Filter update period from the message stamps
+        auto dt = 0.0;
+        if (!last_stamp.isZero())
+        {
+          dt = std::clamp((msg->header.stamp - last_stamp).toSec(), 0.0, 0.1);
+        }
+        last_stamp = msg->header.stamp;
+
+        estimator.update(dt, orientation, accel, gyro, joint_states_map);
+        const RobotStateCoM& com_state = estimator.state();
+
+        const math::Quaternion quat_wb(com_state.Rwb);
+
+        quadruped_msgs::CoMState com_msg;
+        com_msg.pose.orientation.w = quat_wb.w();
+        com_msg.pose.orientation.x = quat_wb.x();
+        com_msg.pose.orientation.y = quat_wb.y();
+        com_msg.pose.orientation.z = quat_wb.z();
+
+        com_msg.pose.position.x = com_state.x(0);
+        com_msg.pose.position.y = com_state.x(1);
+        com_msg.pose.position.z = com_state.x(2);
+
+        com_msg.twist.linear.x = com_state.xdot(0);
+        com_msg.twist.linear.y = com_state.xdot(1);
+        com_msg.twist.linear.z = com_state.xdot(2);
+
+        com_msg.twist.angular.x = com_state.w(0);
+        com_msg.twist.angular.y = com_state.w(1);
+        com_msg.twist.angular.z = com_state.w(2);
+
+        com_pub.publish(com_msg);
+      };
+
+  ros::Subscriber imu_sub = nh.subscribe("imu", 1, imuCallback);
+  ros::Subscriber joint_sub = nh.subscribe("joint_states", 1, jointCallback);
+
+  ros::spin();
+
+  ros::shutdown();
+  return 0;
+}
@@ -0,0 +1,148 @@
+/**
+ * @file telemetry_to_csv.cpp
+ * @author Boston Cleek
+ * @date 2021-10-30
+ * @brief Convert a binary telemetry log to CSV
+ *
+ * @details Reads a ring buffer written by the TelemetryLogger and
+ * prints the records to stdout in chronological order:
+ *
+ *    telemetry_to_csv /tmp/quadruped_telemetry.bin > telemetry.csv
+ */
+
+// C++
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <quadruped_controller/telemetry.hpp>
+
+using quadruped_controller::telemetry::TELEMETRY_MAGIC;
+using quadruped_controller::telemetry::TelemetryFileHeader;
+using quadruped_controller::telemetry::TelemetryRecord;
+
+static const std::vector<std::string> leg_names = { "RL", "FL", "RR", "FR" };
+static const std::vector<std::string> joint_names = { "hip", "thigh", "calf" };
+
+int main(int argc, char** argv)
+{
+  if (argc != 2)
+  {
+    std::cerr << "Usage: telemetry_to_csv <telemetry log>" << std::endl;
+    return 1;
+  }
+
+  std::ifstream log(argv[1], std::ios::binary);
+  if (!log)
+  {
+    std::cerr << "Failed to open: " << argv[1] << std::endl;
+    return 1;
+  }
+
+  TelemetryFileHeader header;
+  log.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+  if (!log || std::memcmp(header.magic, TELEMETRY_MAGIC, sizeof(header.magic)) != 0)
+  {
+    std::cerr << "Not a telemetry log: " << argv[1] << std::endl;
+    return 1;
+  }
+
+  if (header.record_size != sizeof(TelemetryRecord))
+  {
+    std::cerr << "Telemetry schema mismatch. Log record size: " << header.record_size
+              << ", expected: " << sizeof(TelemetryRecord) << std::endl;
+    return 1;
+  }
+
+  std::vector<TelemetryRecord> ring(header.capacity);
+  log.read(reinterpret_cast<char*>(ring.data()),
+           static_cast<std::streamsize>(header.capacity * sizeof(TelemetryRecord)));
+
+  const uint64_t written = header.written.load();
+  const uint64_t count = std::min<uint64_t>(written, header.capacity);
+  const uint64_t first = written - count;
+
+  // Header row
+  std::cout << "stamp_ns,qw,qx,qy,qz,x,y,z,vx,vy,vz,wx,wy,wz"
+            << ",x_d,y_d,z_d,vx_d,vy_d,vz_d,wx_d,wy_d,wz_d";
+
+  for (const auto& leg : leg_names)
+  {
+    std::cout << "," << leg << "_fx," << leg << "_fy," << leg << "_fz";
+  }
+
+  for (const auto& leg : leg_names)
+  {
+    for (const auto& joint : joint_names)
+    {
+      std::cout << "," << leg << "_" << joint << "_tau";
+    }
+  }
+
+  for (const auto& leg : leg_names)
+  {
+    std::cout << "," << leg << "_phase," << leg << "_state";
+  }
+
+  std::cout << ",qp_failures\n";
+
+  // Records in chronological order
+  for (uint64_t i = first; i < written; i++)
+  {
+    const TelemetryRecord& r = ring.at(i % header.capacity);
+
+    std::cout << r.stamp_ns;
+
+    for (unsigned int j = 0; j < 4; j++)
+    {
+      std::cout << "," << r.orientation[j];
+    }
+
+    for (unsigned int j = 0; j < 3; j++)
+    {
+      std::cout << "," << r.position[j];
+    }
+    for (unsigned int j = 0; j < 3; j++)
+    {
+      std::cout << "," << r.linear_velocity[j];
+    }
+    for (unsigned int j = 0; j < 3; j++)
+    {
+      std::cout << "," << r.angular_velocity[j];
+    }
+
+    for (unsigned int j = 0; j < 3; j++)
+    {
+      std::cout << "," << r.position_desired[j];
+    }
+    for (unsigned int j = 0; j < 3; j++)
+    {
+      std::cout << "," << r.linear_velocity_desired[j];
+    }
+    for (unsigned int j = 0; j < 3; j++)
+    {
+      std::cout << "," << r.angular_velocity_desired[j];
+    }
+
+    for (unsigned int j = 0; j < 12; j++)
+    {
+      std::cout << "," << r.grf[j];
+    }
+
+    for (unsigned int j = 0; j < 12; j++)
+    {
+      std::cout << "," << r.torque[j];
+    }
+
+    for (unsigned int j = 0; j < 4; j++)
+    {
+      std::cout << "," << r.gait_phase[j] << "," << r.leg_state[j];
+    }
+
+    std::cout << "," << r.qp_failures << "\n";
+  }
+
+  return 0;
+}
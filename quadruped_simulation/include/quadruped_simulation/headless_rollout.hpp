@@ -0,0 +1,123 @@
+/**
+ * @file headless_rollout.hpp
+ * @date 2021-11-20
+ * @author Boston Cleek
+ * @brief Headless faster-than-real-time controller rollouts
+ */
+#ifndef HEADLESS_ROLLOUT_HPP
+#define HEADLESS_ROLLOUT_HPP
+
+// C++
+#include <string>
+#include <vector>
+
+#include <quadruped_controller/types.hpp>
+
+namespace quadruped_simulation
+{
+using arma::vec;
+
+/**
+ * @brief One rollout configuration
+ * @details Defaults mirror mit_cheetah_config.yaml and physics.yaml so a
+ * sweep only needs to override the gains under test and the URDF path.
+ */
+struct RolloutConfig
+{
+  // Simulation
+  std::string urdf_path;                // robot description
+  double duration = 10.0;               // rollout length in sim time (s)
+  double time_step = 0.001;             // physics integration step (s)
+  double control_frequency = 300.0;     // control loop rate (Hz)
+  double static_friction = 1.0;         // ground static friction
+  double dynamic_friction = 1.0;        // ground dynamic friction
+  double penetration_allowance = 0.001; // contact stiffness knob (m)
+
+  // Robot initial configuration
+  std::string base_link_name = "trunk";
+  vec init_position = { 0.0, 0.0, 0.06 };          // world [x, y, z]
+  vec init_orientation = { 0.0, 0.0, 0.0, 1.0 };   // world [qx, qy, qz, qw]
+  vec init_joint_positions = { 0.0, 0.0, 0.0,  0.0,  1.61,  1.61,
+                               1.61, 1.61, -2.78, -2.78, -2.78, -2.78 };
+
+  // Commanded body twist once the gait is running [vx, vy, vz, wx, wy, wz]
+  vec twist_cmd = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+
+  // Gait and swing trajectory
+  double t_stance = 0.8;        // stance time (s)
+  double t_swing = 0.18;        // swing time (s)
+  double foot_height = 0.08;    // max swing foot height (m)
+  vec phase_offset = { 0.0, 0.5, 0.5, 0.0 };  // [RL FL RR FR]
+
+  // Dynamics
+  double mu = 0.8;       // friction coefficient
+  double mass = 11.0;    // total mass (kg)
+  double fzmin = 10.0;   // min normal force (N)
+  double fzmax = 120.0;  // max normal force (N)
+  vec Ib_diagonal = { 0.011253, 0.036203, 0.042673 };  // trunk inertia (kg*m^2)
+
+  // Balance controller gains (the usual sweep variables)
+  double w_diagonal = 1e-5;
+  vec s_diagonal = { 1.0, 1.0, 1.0, 10.0, 10.0, 5.0 };
+  vec kff = { 0.0, 0.0, 0.15, 0.0, 0.0, 0.0 };
+  vec kp_p = { 100.0, 100.0, 100.0 };
+  vec kd_p = { 50.0, 50.0, 50.0 };
+  vec kp_w = { 5000.0, 5000.0, 5000.0 };
+  vec kd_w = { 500.0, 500.0, 500.0 };
+
+  // Swing leg joint PD gains
+  vec jc_kff = { 0.0, 0.0, 0.0 };
+  vec jc_kp = { 40.0, 40.0, 50.0 };
+  vec jc_kd = { 1.0, 1.0, 1.0 };
+
+  // Torque limits (N*m)
+  double tau_min = -20.0;
+  double tau_max = 20.0;
+
+  // Standing configuration
+  double standing_height = 0.26;  // desired COM height (m)
+
+  // Fall detection
+  double min_height = 0.12;  // COM height treated as a fall (m)
+  double max_tilt = 0.8;     // body z-axis tilt treated as a fall (rad)
+};
+
+/** @brief Per-rollout result summary */
+struct RolloutResult
+{
+  bool stood_up = false;          // reached the standing height
+  bool fell = false;              // fall detected
+  double fall_time = 0.0;         // sim time of the fall (s)
+  double position_rmse = 0.0;     // COM position tracking error (m)
+  double velocity_rmse = 0.0;     // COM linear velocity tracking error (m/s)
+  double yaw_rate_rmse = 0.0;     // COM yaw rate tracking error (rad/s)
+  unsigned int qp_failures = 0;   // total failed QP solves
+  double sim_time = 0.0;          // simulated time (s)
+  double wall_time = 0.0;         // wall-clock time (s)
+};
+
+/**
+ * @brief Run one headless rollout of the full commander pipeline
+ * @param config - rollout configuration
+ * @return result summary
+ * @details Instantiates the same MultibodyPlant setup as the simulation
+ * interface node but without visualization or ROS - the finalized
+ * diagram comes from the shared plant template cache, so repeated
+ * rollouts of one scene skip the build - and closes the loop
+ * in-process: gait schedule, foothold planning, swing trajectories and
+ * IK, balance QP, and jacobian transpose control. The gait phases are
+ * derived from sim time rather than the wall clock so the rollout runs
+ * as fast as the hardware allows.
+ */
+RolloutResult runRollout(const RolloutConfig& config);
+
+/**
+ * @brief Run independent rollouts in parallel
+ * @param configs - one configuration per rollout
+ * @param num_threads - worker threads, 0 uses the hardware concurrency
+ * @return result summaries in the same order as the configurations
+ */
+std::vector<RolloutResult> runRollouts(const std::vector<RolloutConfig>& configs,
+                                       unsigned int num_threads = 0);
+}  // namespace quadruped_simulation
+#endif
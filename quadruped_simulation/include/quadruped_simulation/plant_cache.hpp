@@ -0,0 +1,59 @@
+/**
+ * @file plant_cache.hpp
+ * @date 2021-11-27
+ * @author Boston Cleek
+ * @brief Process-wide cache of finalized Drake plant diagrams
+ */
+#ifndef PLANT_CACHE_HPP
+#define PLANT_CACHE_HPP
+
+// C++
+#include <memory>
+#include <string>
+
+// Drake
+#include <drake/multibody/plant/multibody_plant.h>
+#include <drake/systems/framework/diagram.h>
+
+namespace quadruped_simulation
+{
+/** @brief Physical scene description, the cache key */
+struct PlantSceneConfig
+{
+  std::string urdf_path;                 // robot description
+  double time_step = 0.001;              // physics integration step (s)
+  double static_friction = 1.0;          // ground static friction
+  double dynamic_friction = 1.0;         // ground dynamic friction
+  double penetration_allowance = 0.001;  // contact stiffness knob (m)
+  bool visualize = false;  // add DrakeVisualizer and contact result publishing
+};
+
+/**
+ * @brief Finalized diagram shared between simulator instances
+ * @details The diagram is immutable after Build() and every plant method
+ * used after finalization takes an explicit context, so any number of
+ * simulators may share one template concurrently as long as each creates
+ * its own context.
+ */
+struct PlantTemplate
+{
+  std::shared_ptr<const drake::systems::Diagram<double>> diagram;  // owns the plant
+  const drake::multibody::MultibodyPlant<double>* plant = nullptr;  // subsystem view
+};
+
+/**
+ * @brief Get the finalized diagram for a scene, building it at most once
+ * @param config - scene description
+ * @return shared diagram template
+ * @details Parsing the URDF and finalizing the plant dominate simulator
+ * startup, so the built diagram is cached for the life of the process
+ * keyed by a hash of the URDF contents and the physics parameters -
+ * editing the URDF or changing a parameter rebuilds, a repeat request
+ * clones a context off the cached template in well under a second. Drake
+ * offers no serialization of a finalized plant, so the cache does not
+ * persist across processes; batch sweeps should reuse one process (see
+ * runRollouts) to amortize the first build.
+ */
+PlantTemplate getPlantTemplate(const PlantSceneConfig& config);
+}  // namespace quadruped_simulation
+#endif
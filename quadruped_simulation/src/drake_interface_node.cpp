@@ -10,7 +10,9 @@
  *    joint_states (sensor_msgs/JointState) - joint names, positions, and velocities
  *    com_state (quadruped_msgs/CoMState) - COM pose and velocity twist in world frame
  * @SUBSCRIBES:
- *    joint_torque_cmd (quadruped_msgs/JointTorqueCmd) - joint torques
+ *    joint_torque_order (quadruped_msgs/JointTorqueOrder) - latched actuator ordering
+ *    joint_torque_stream (quadruped_msgs/JointTorqueStream) - joint torques in the latched order
+ *    joint_torque_cmd (quadruped_msgs/JointTorqueCmd) - named joint torques (legacy/tooling)
  * @SERVICES:
  *    start_position (std_srvs/Empty) - sets robot to starting configuration
  */
@@ -18,7 +20,10 @@
 // TODO: publish actual reaction forces at feet and joint torques
 
 // C++
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <thread>
 #include <filesystem>
 
 // ROS
@@ -27,22 +32,24 @@
 #include <sensor_msgs/JointState.h>
 
 // Quadruped Control
+#include <quadruped_controller/realtime.hpp>
+#include <quadruped_controller/shared_memory_transport.hpp>
 #include <quadruped_msgs/CoMState.h>
 #include <quadruped_msgs/JointTorqueCmd.h>
+#include <quadruped_msgs/JointTorqueOrder.h>
+#include <quadruped_msgs/JointTorqueStream.h>
+
+// Quadruped Simulation
+#include <quadruped_simulation/plant_cache.hpp>
 
 // Drake
 #include <drake/systems/framework/framework_common.h>
 #include <drake/systems/framework/vector_base.h>
-#include <drake/common/find_resource.h>
-#include <drake/geometry/drake_visualizer.h>
-#include <drake/geometry/scene_graph.h>
-#include <drake/multibody/parsing/parser.h>
-#include <drake/multibody/plant/contact_results_to_lcm.h>
 #include <drake/systems/analysis/simulator.h>
+#include <drake/math/rigid_transform.h>
 #include <drake/multibody/plant/multibody_plant.h>
-#include <drake/systems/framework/diagram_builder.h>
-#include <drake/systems/controllers/pid_controller.h>
-#include <drake/manipulation/util/robot_plan_utils.h>
+
+namespace shm = quadruped_controller::shm;
 
 using drake::math::RigidTransformd;
 using drake::systems::VectorBase;
@@ -52,17 +59,37 @@ using Eigen::Vector3d;
 using Eigen::VectorXd;
 
 const static std::string LOGNAME = "drake_interface";
-static bool joint_cmd_received = false;
-static bool start_config_received = false;
+static std::atomic_bool joint_cmd_received = false;
+static std::atomic_bool start_config_received = false;
 
 // The joint torque map, maps joint actuator names to index in control vector.
 static std::map<std::string, unsigned int> joint_torque_map;
-// Control vector
-static VectorXd tau;
+
+// Stream index i maps to the control vector entry for actuator i in the
+// latched joint_torque_order; the string lookups happen once at startup
+static std::vector<unsigned int> stream_torque_index;
+
+/** @brief Joint torque command in control vector order */
+struct TorqueCommand
+{
+  double tau[12];
+};
+
+/** @brief Simulation state shared between the physics and publisher threads */
+struct SimStateSnapshot
+{
+  quadruped_controller::shm::JointStateSnapshot joint_states;
+  quadruped_controller::shm::CoMStateSnapshot com_state;
+};
+
+// Latest torque command from the subscriber thread to the physics thread
+static quadruped_controller::realtime::StateBuffer<TorqueCommand> torque_cmd_buffer;
+
+// Latest simulation state from the physics thread to the publisher thread
+static quadruped_controller::realtime::StateBuffer<SimStateSnapshot> sim_state_buffer;
 
 void jointTorqueCallback(const quadruped_msgs::JointTorqueCmd::ConstPtr& msg)
 {
-  joint_cmd_received = true;
   if (msg->actuator_name.size() != msg->torque.size())
   {
     ROS_ERROR_STREAM_NAMED(LOGNAME, "The number of joint torque commands do not match "
@@ -70,12 +97,13 @@ void jointTorqueCallback(const quadruped_msgs::JointTorqueCmd::ConstPtr& msg)
     return;
   }
 
+  TorqueCommand torque_cmd = torque_cmd_buffer.read();
   for (unsigned int i = 0; i < msg->actuator_name.size(); i++)
   {
     try
     {
       const auto index = joint_torque_map.at(msg->actuator_name.at(i));
-      tau(index) = msg->torque.at(i);
+      torque_cmd.tau[index] = msg->torque.at(i);
       // std::cout << msg->actuator_name.at(i) << " " << index << std::endl;
     }
     catch (const std::out_of_range& e)
@@ -83,7 +111,67 @@ void jointTorqueCallback(const quadruped_msgs::JointTorqueCmd::ConstPtr& msg)
       ROS_ERROR_STREAM_NAMED(LOGNAME, "Actuator name does not exist in joint torque map");
     }
   }
-  // std::cout << "Tau: \n" << tau << std::endl;
+
+  torque_cmd_buffer.write(torque_cmd);
+  joint_cmd_received = true;
+}
+
+void torqueOrderCallback(const quadruped_msgs::JointTorqueOrder::ConstPtr& msg)
+{
+  // Resolve the actuator names to control vector indices once; the
+  // per-tick stream is then a direct indexed copy
+  std::vector<unsigned int> index;
+  index.reserve(msg->actuator_name.size());
+
+  if (msg->actuator_name.size() > 12)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Torque order contains %lu actuators, expected at most 12",
+                    msg->actuator_name.size());
+    return;
+  }
+
+  for (const auto& actuator_name : msg->actuator_name)
+  {
+    const auto search = joint_torque_map.find(actuator_name);
+    if (search == joint_torque_map.end())
+    {
+      ROS_ERROR_NAMED(LOGNAME,
+                      "Actuator name in torque order does not exist in joint torque "
+                      "map: %s",
+                      actuator_name.c_str());
+      return;
+    }
+
+    index.emplace_back(search->second);
+  }
+
+  stream_torque_index = index;
+  ROS_INFO_NAMED(LOGNAME, "Latched torque command order for %lu actuators",
+                 stream_torque_index.size());
+}
+
+void torqueStreamCallback(const quadruped_msgs::JointTorqueStream::ConstPtr& msg)
+{
+  if (stream_torque_index.empty())
+  {
+    ROS_WARN_THROTTLE_NAMED(1.0, LOGNAME,
+                            "Torque stream received before the actuator order latched");
+    return;
+  }
+
+  TorqueCommand torque_cmd = torque_cmd_buffer.read();
+  for (unsigned int i = 0; i < stream_torque_index.size(); i++)
+  {
+    // The stream is three torques per leg: masked legs keep their
+    // previous command
+    if (msg->leg_mask & (1u << (i / 3)))
+    {
+      torque_cmd.tau[stream_torque_index[i]] = msg->torque[i];
+    }
+  }
+
+  torque_cmd_buffer.write(torque_cmd);
+  joint_cmd_received = true;
 }
 
 bool startConfigCallback(std_srvs::Empty::Request&, std_srvs::Empty::Response&)
@@ -105,6 +193,13 @@ int main(int argc, char** argv)
   ros::Subscriber joint_torque_sub =
       nh.subscribe("joint_torque_cmd", 1, jointTorqueCallback);
 
+  // Fast command path: the actuator order latches once and the stream
+  // carries only the fixed torque array
+  ros::Subscriber torque_order_sub =
+      nh.subscribe("joint_torque_order", 1, torqueOrderCallback);
+  ros::Subscriber torque_stream_sub =
+      nh.subscribe("joint_torque_stream", 1, torqueStreamCallback);
+
   ros::ServiceServer start_server =
       nh.advertiseService("start_position", startConfigCallback);
 
@@ -120,6 +215,7 @@ int main(int argc, char** argv)
   const auto penetration_allowance = pnh.param<double>("penetration_allowance", 0.001);
   // const auto stiction_tolerance = pnh.param<double>("stiction_tolerance", 0.001);
   const auto real_time_rate = pnh.param<double>("real_time_rate", 1.0);
+  const auto publish_frequency = pnh.param<double>("publish_frequency", 500.0);
 
   // Robot initial pose
   // See MultibodyPlant SetPositions() to set init joint positions
@@ -165,72 +261,74 @@ int main(int argc, char** argv)
     joint_torque_map.emplace(joint_actuator_names.at(i), i);
   }
 
-  // Place base_link relative to world_body
-  const Vector3d start_position(init_position.data());
-  const Quaterniond start_orientation(init_orientation.data());
-  const RigidTransformd Twb(start_orientation, start_position);
+  // Zero-copy shared-memory transport to the commander. When enabled, joint
+  // and CoM state snapshots are written every physics step and torque
+  // commands are read back without serialization; ROS publishing becomes an
+  // optional mirror for tooling.
+  const auto use_shm = pnh.param<bool>("shm/enabled", false);
+  const auto mirror_topics = pnh.param<bool>("shm/mirror_topics", true);
 
-  // Ground plane color
-  const drake::Vector4<double> green(0.5, 1.0, 0.5, 1.0);
+  std::unique_ptr<shm::Channel<shm::JointStateSnapshot>> joint_state_channel;
+  std::unique_ptr<shm::Channel<shm::CoMStateSnapshot>> com_state_channel;
+  std::unique_ptr<shm::Channel<shm::JointTorqueSnapshot>> joint_torque_channel;
 
-  // Consructs the system diagram
-  drake::systems::DiagramBuilder<double> builder;
+  // Torque snapshot index i maps to the control vector entry for actuator i
+  std::vector<unsigned int> shm_torque_index;
 
-  // Adds a MultibodyPlant and a SceneGraph instance to a diagram builder,
-  // connecting the geometry ports.
-  auto pair = drake::multibody::AddMultibodyPlantSceneGraph(
-      &builder, std::make_unique<drake::multibody::MultibodyPlant<double>>(time_step));
-
-  // Represents a robot in a tree of bodies
-  drake::multibody::MultibodyPlant<double>& plant = pair.plant;
-
-  // Parses SDF and URDF input files into a MultibodyPlant and (optionally) a SceneGraph.
-  drake::multibody::Parser(&plant).AddModelFromFile(urdf_path);
-
-  // Add model of the ground.
-  // Registers geometry in a SceneGraph with a given geometry::Shape
-  // to be used for visualization of a given body.
-  plant.RegisterVisualGeometry(plant.world_body(), RigidTransformd(),
-                               drake::geometry::HalfSpace(), "GroundVisualGeometry",
-                               green);
+  if (use_shm)
+  {
+    ROS_INFO_STREAM_NAMED(LOGNAME, "Using shared-memory state transport");
 
-  plant.set_penetration_allowance(penetration_allowance);
+    joint_state_channel =
+        std::make_unique<shm::Channel<shm::JointStateSnapshot>>(shm::JOINT_STATE_CHANNEL);
+    com_state_channel =
+        std::make_unique<shm::Channel<shm::CoMStateSnapshot>>(shm::COM_STATE_CHANNEL);
+    joint_torque_channel = std::make_unique<shm::Channel<shm::JointTorqueSnapshot>>(
+        shm::JOINT_TORQUE_CHANNEL);
 
-  // For a time-stepping model only static friction is used.
-  const drake::multibody::CoulombFriction<double> ground_friction(static_friction,
-                                                                  dynamic_friction);
+    shm_torque_index.reserve(num_joints);
+    for (unsigned int i = 0; i < num_joints; i++)
+    {
+      shm_torque_index.emplace_back(joint_torque_map.at(joint_actuator_names.at(i)));
+    }
+  }
 
-  // Registers geometry in a SceneGraph with a given geometry::Shape
-  // to be used for the contact modeling of a given body.
-  plant.RegisterCollisionGeometry(plant.world_body(), RigidTransformd(),
-                                  drake::geometry::HalfSpace(), "GroundCollisionGeometry",
-                                  ground_friction);
+  // Place base_link relative to world_body
+  const Vector3d start_position(init_position.data());
+  const Quaterniond start_orientation(init_orientation.data());
+  const RigidTransformd Twb(start_orientation, start_position);
 
-  // This method must be called after all elements in the model
-  // (joints, bodies, force elements, constraints, etc.) are added
-  //  and before any computations are performed.
-  plant.Finalize();
+  // The finalized diagram comes from the process-wide template cache:
+  // the URDF parse and plant finalization run at most once per scene, so
+  // hosting processes that construct the simulator repeatedly only pay
+  // the build cost on the first request
+  quadruped_simulation::PlantSceneConfig scene_config;
+  scene_config.urdf_path = urdf_path;
+  scene_config.time_step = time_step;
+  scene_config.static_friction = static_friction;
+  scene_config.dynamic_friction = dynamic_friction;
+  scene_config.penetration_allowance = penetration_allowance;
+  scene_config.visualize = true;
+
+  const quadruped_simulation::PlantTemplate plant_template =
+      quadruped_simulation::getPlantTemplate(scene_config);
+
+  // Represents a robot in a tree of bodies. The template is finalized
+  // and shared: all access below goes through this node's own context.
+  const drake::multibody::MultibodyPlant<double>& plant = *plant_template.plant;
+  const drake::systems::Diagram<double>& diagram = *plant_template.diagram;
 
   if (!plant.is_finalized())
   {
     ROS_ERROR_STREAM_NAMED(LOGNAME, "plant failed to finalize");
   }
 
-  // Publish contact results to drake_visualizer.
-  drake::multibody::ConnectContactResultsToDrakeVisualizer(&builder, plant);
-
-  // Connects the newly added DrakeVisualizer to the given SceneGraph
-  drake::geometry::DrakeVisualizerd::AddToBuilder(&builder, pair.scene_graph);
-
-  // Builds the Diagram
-  auto diagram = builder.Build();
-
   // Create a context for this system:
   std::unique_ptr<drake::systems::Context<double>> diagram_context =
-      diagram->CreateDefaultContext();
+      diagram.CreateDefaultContext();
 
   drake::systems::Context<double>& plant_context =
-      diagram->GetMutableSubsystemContext(plant, diagram_context.get());
+      diagram.GetMutableSubsystemContext(plant, diagram_context.get());
 
   ROS_INFO_NAMED(LOGNAME, "Number of actuated joints: %i", plant.num_actuated_dofs());
   ROS_INFO_NAMED(LOGNAME, "Number of actuaters: %i", plant.num_actuators());
@@ -244,9 +342,8 @@ int main(int argc, char** argv)
   // ROS_INFO_NAMED(LOGNAME, "Output port name: %s", output_port.get_name().c_str());
 
   // Set initial joint torque
-  // VectorXd tau = VectorXd::Zero(num_joints);
-  tau = Eigen::Map<VectorXd, Eigen::Unaligned>(init_joint_torques.data(),
-                                               init_joint_torques.size());
+  VectorXd tau = Eigen::Map<VectorXd, Eigen::Unaligned>(init_joint_torques.data(),
+                                                        init_joint_torques.size());
 
   input_port.FixValue(&plant_context, tau);
 
@@ -265,121 +362,165 @@ int main(int argc, char** argv)
   plant.SetFreeBodyPoseInWorldFrame(&plant_context, base_link, Twb);
 
   // Advancing the state of hybrid dynamic systems forward in time.
-  drake::systems::Simulator simulator(*diagram, std::move(diagram_context));
+  drake::systems::Simulator simulator(diagram, std::move(diagram_context));
   simulator.Initialize();
   simulator.set_target_realtime_rate(real_time_rate);
   // simulator.set_publish_every_time_step(true);
   // simulator.AdvanceTo(10.0);
 
-  auto current_time = 0.0;
+  // Physics thread: steps the simulator continuously (throttled only by
+  // the configured real_time_rate) and exports state snapshots into the
+  // double buffer. It never touches ROS publishing.
+  std::atomic_bool physics_running = true;
+  std::thread physics_thread([&] {
+    auto current_time = 0.0;
+    while (physics_running)
+    {
+      if (start_config_received)
+      {
+        // Reset initial joint positions
+        Eigen::VectorBlock<drake::VectorX<double>> state_vec =
+            plant_context.get_mutable_discrete_state(0).get_mutable_value();
+        state_vec.segment(7, init_joint_positions.size()) = init_joint_vec;
+
+        // Reset initial joint torques
+        tau = Eigen::Map<VectorXd, Eigen::Unaligned>(init_joint_torques.data(),
+                                                     init_joint_torques.size());
+        input_port.FixValue(&plant_context, tau);
+
+        // Reset free body pose in world
+        plant.SetFreeBodyPoseInWorldFrame(&plant_context, base_link, Twb);
+
+        start_config_received = false;
+      }
+
+      if (use_shm)
+      {
+        // Latest torque command in the canonical actuator order
+        shm::JointTorqueSnapshot torque_snapshot;
+        if (joint_torque_channel->read(torque_snapshot))
+        {
+          for (unsigned int i = 0; i < num_joints; i++)
+          {
+            tau(shm_torque_index.at(i)) = torque_snapshot.torque[i];
+          }
+
+          input_port.FixValue(&plant_context, tau);
+        }
+      }
+
+      else if (joint_cmd_received)
+      {
+        const TorqueCommand torque_cmd = torque_cmd_buffer.read();
+        tau = Eigen::Map<const VectorXd>(torque_cmd.tau, num_joints);
+
+        input_port.FixValue(&plant_context, tau);
+        joint_cmd_received = false;
+      }
+
+      simulator.AdvanceTo(current_time);
+      current_time += viz_time_step;
+
+      // states
+      // Orientation: qw, qx, qy, qz
+      // Position: x, y, z
+      // Joint positions
+      // Angular velocity: rdot, pdot, ydot
+      // Velocity vector: xdot, ydot, zdot
+      // Joint velocity
+      // View into the discrete state, nothing is copied on the stepping path
+      const drake::VectorX<double>& state_vector =
+          simulator.get_context().get_discrete_state(0).value();
+
+      const auto stamp_ns =
+          static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch() /
+                                std::chrono::nanoseconds(1));
+
+      // Snapshots follow the joint_states topic order
+      SimStateSnapshot snapshot{};
+      snapshot.joint_states.stamp_ns = stamp_ns;
+      Eigen::Map<VectorXd>(snapshot.joint_states.position, num_joints) =
+          state_vector.segment(7, num_joints);
+      Eigen::Map<VectorXd>(snapshot.joint_states.velocity, num_joints) =
+          state_vector.tail(num_joints);
+
+      snapshot.com_state.stamp_ns = stamp_ns;
+      Eigen::Map<Eigen::Vector4d>(snapshot.com_state.orientation) =
+          state_vector.head(4);
+      Eigen::Map<Vector3d>(snapshot.com_state.position) = state_vector.segment(4, 3);
+      Eigen::Map<Vector3d>(snapshot.com_state.angular_velocity) =
+          state_vector.segment(7 + num_joints, 3);
+      Eigen::Map<Vector3d>(snapshot.com_state.linear_velocity) =
+          state_vector.segment(10 + num_joints, 3);
+
+      sim_state_buffer.write(snapshot);
+
+      if (use_shm)
+      {
+        joint_state_channel->write(snapshot.joint_states);
+        com_state_channel->write(snapshot.com_state);
+      }
+    }
+  });
+
+  // Publisher loop: mirrors the latest snapshot to ROS at its own rate
+  ros::Rate rate(publish_frequency);
   while (nh.ok())
   {
     ros::spinOnce();
 
-    // TODO: which context to use? I think this is required to get the current trajectory context.
-    const drake::systems::Context<double>& context = simulator.get_context();
-
-    if (start_config_received)
-    {
-      // Reset initial joint positions
-      Eigen::VectorBlock<drake::VectorX<double>> state_vec =
-          plant_context.get_mutable_discrete_state(0).get_mutable_value();
-      state_vec.segment(7, init_joint_positions.size()) = init_joint_vec;
-
-      // Reset initial joint torques
-      tau = Eigen::Map<VectorXd, Eigen::Unaligned>(init_joint_torques.data(),
-                                                   init_joint_torques.size());
-      input_port.FixValue(&plant_context, tau);
-
-      // // Reset free body pose in world
-      plant.SetFreeBodyPoseInWorldFrame(&plant_context, base_link, Twb);
-
-      start_config_received = false;
-    }
-
-    if (joint_cmd_received)
+    if (!use_shm || mirror_topics)
     {
-      input_port.FixValue(&plant_context, tau);
-      joint_cmd_received = false;
+      const SimStateSnapshot snapshot = sim_state_buffer.read();
+
+      // Nothing to mirror until the physics thread publishes a snapshot
+      if (snapshot.com_state.stamp_ns == 0)
+      {
+        rate.sleep();
+        continue;
+      }
+
+      // TODO: add effort to msg?
+      sensor_msgs::JointState js_msg;
+      js_msg.header.frame_id = "";
+      js_msg.header.stamp = ros::Time::now();
+      js_msg.name = joint_names;
+      js_msg.position.assign(snapshot.joint_states.position,
+                             snapshot.joint_states.position + num_joints);
+      js_msg.velocity.assign(snapshot.joint_states.velocity,
+                             snapshot.joint_states.velocity + num_joints);
+
+      joint_pub.publish(js_msg);
+
+      ////////////////
+      // CoM
+      quadruped_msgs::CoMState com_msg;
+      com_msg.pose.orientation.w = snapshot.com_state.orientation[0];
+      com_msg.pose.orientation.x = snapshot.com_state.orientation[1];
+      com_msg.pose.orientation.y = snapshot.com_state.orientation[2];
+      com_msg.pose.orientation.z = snapshot.com_state.orientation[3];
+
+      com_msg.pose.position.x = snapshot.com_state.position[0];
+      com_msg.pose.position.y = snapshot.com_state.position[1];
+      com_msg.pose.position.z = snapshot.com_state.position[2];
+
+      com_msg.twist.angular.x = snapshot.com_state.angular_velocity[0];
+      com_msg.twist.angular.y = snapshot.com_state.angular_velocity[1];
+      com_msg.twist.angular.z = snapshot.com_state.angular_velocity[2];
+
+      com_msg.twist.linear.x = snapshot.com_state.linear_velocity[0];
+      com_msg.twist.linear.y = snapshot.com_state.linear_velocity[1];
+      com_msg.twist.linear.z = snapshot.com_state.linear_velocity[2];
+
+      com_pub.publish(com_msg);
     }
 
-    // states
-    // Orientation: qw, qx, qy, qz
-    // Position: x, y, z
-    // Joint positions
-    // Angular velocity: rdot, pdot, ydot
-    // Velocity vector: xdot, ydot, zdot
-    // Joint velocity
-    const drake::VectorX<double>& state_vector =
-        context.get_discrete_state_vector().CopyToVector();
-
-    ////////////////
-    // Joint states
-    std::vector<double> joint_positions(num_joints);
-    VectorXd::Map(&joint_positions.at(0), num_joints) =
-        state_vector.segment(7, num_joints);
-
-    std::vector<double> joint_velocities(num_joints);
-    VectorXd::Map(&joint_velocities.at(0), num_joints) = state_vector.tail(num_joints);
-
-    // TODO: add effort to msg?
-    sensor_msgs::JointState js_msg;
-    js_msg.header.frame_id = "";
-    js_msg.header.stamp = ros::Time::now();
-    js_msg.name = joint_names;
-    js_msg.position = joint_positions;
-    js_msg.velocity = joint_velocities;
-
-    joint_pub.publish(js_msg);
-
-    ////////////////
-    // CoM
-    quadruped_msgs::CoMState com_msg;
-    com_msg.pose.orientation.w = state_vector(0);
-    com_msg.pose.orientation.x = state_vector(1);
-    com_msg.pose.orientation.y = state_vector(2);
-    com_msg.pose.orientation.z = state_vector(3);
-
-    com_msg.pose.position.x = state_vector(4);
-    com_msg.pose.position.y = state_vector(5);
-    com_msg.pose.position.z = state_vector(6);
-
-    com_msg.twist.angular.x = state_vector(7 + num_joints);
-    com_msg.twist.angular.y = state_vector(8 + num_joints);
-    com_msg.twist.angular.z = state_vector(9 + num_joints);
-
-    com_msg.twist.linear.x = state_vector(10 + num_joints);
-    com_msg.twist.linear.y = state_vector(11 + num_joints);
-    com_msg.twist.linear.z = state_vector(12 + num_joints);
-
-    com_pub.publish(com_msg);
-
-    // const drake::multibody::Joint<double>& RL_hip_joint =
-    // plant.GetJointByName("RL_hip_joint"); const drake::multibody::Joint<double>&
-    // FL_hip_joint = plant.GetJointByName("FL_hip_joint"); const
-    // drake::multibody::Joint<double>& RR_hip_joint =
-    // plant.GetJointByName("RR_hip_joint"); const drake::multibody::Joint<double>&
-    // FR_hip_joint = plant.GetJointByName("FR_hip_joint");
-
-    // const double& RL_hip_joint_velocity = RL_hip_joint.GetOneVelocity(context);
-    // const double& FL_hip_joint_velocity = FL_hip_joint.GetOneVelocity(context);
-    // const double& RR_hip_joint_velocity = RR_hip_joint.GetOneVelocity(context);
-    // const double& FR_hip_joint_velocity = FR_hip_joint.GetOneVelocity(context);
-
-    // std::cout << "Joint velocity test: \n";
-    // std::cout << RL_hip_joint_velocity << "\n";
-    // std::cout << FL_hip_joint_velocity << "\n";
-    // std::cout << RR_hip_joint_velocity << "\n";
-    // std::cout << FR_hip_joint_velocity << "\n";
-
-    // ROS_INFO_NAMED(LOGNAME, "Num groups: %i, with num elements: %i",
-    // discrete_values.num_groups(), discrete_values.size()); ROS_INFO_NAMED(LOGNAME,
-    // "Real time rate: %s", output_port.GetFullDescription().c_str()); ROS_INFO_NAMED(LOGNAME,
-    // "Real time rate: %f", simulator.get_actual_realtime_rate());
-    simulator.AdvanceTo(current_time);
-    current_time += viz_time_step;
+    rate.sleep();
   }
 
+  physics_running = false;
+  physics_thread.join();
+
   ros::shutdown();
   return 0;
 }
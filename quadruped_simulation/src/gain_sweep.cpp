@@ -0,0 +1,96 @@
+/**
+ * @file gain_sweep.cpp
+ * @date 2021-11-20
+ * @author Boston Cleek
+ * @brief Sweep balance controller gains across parallel headless rollouts
+ *
+ * @details Runs a grid of scale factors over the COM position/orientation
+ * PD gains, one rollout per grid point, spread across cores. Emits one CSV
+ * row per rollout on stdout.
+ *
+ * Usage: gain_sweep <urdf_path> [duration] [num_threads]
+ */
+
+// C++
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include <quadruped_simulation/headless_rollout.hpp>
+
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    std::cerr << "Usage: gain_sweep <urdf_path> [duration] [num_threads]" << std::endl;
+    return 1;
+  }
+
+  quadruped_simulation::RolloutConfig base;
+  base.urdf_path = argv[1];
+
+  if (argc > 2)
+  {
+    base.duration = std::stod(argv[2]);
+  }
+
+  unsigned int num_threads = 0;
+  if (argc > 3)
+  {
+    num_threads = static_cast<unsigned int>(std::stoul(argv[3]));
+  }
+
+  // Scale the stiffness and damping gains about the tuned values
+  const std::vector<double> kp_scales = { 0.25, 0.5, 1.0, 2.0, 4.0 };
+  const std::vector<double> kd_scales = { 0.25, 0.5, 1.0, 2.0, 4.0 };
+
+  std::vector<quadruped_simulation::RolloutConfig> configs;
+  configs.reserve(kp_scales.size() * kd_scales.size());
+
+  for (const auto kp_scale : kp_scales)
+  {
+    for (const auto kd_scale : kd_scales)
+    {
+      quadruped_simulation::RolloutConfig config = base;
+      config.kp_p *= kp_scale;
+      config.kp_w *= kp_scale;
+      config.kd_p *= kd_scale;
+      config.kd_w *= kd_scale;
+      configs.emplace_back(config);
+    }
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+
+  const std::vector<quadruped_simulation::RolloutResult> results =
+      quadruped_simulation::runRollouts(configs, num_threads);
+
+  const auto wall_time =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << "kp_scale,kd_scale,stood_up,fell,fall_time,position_rmse,"
+               "velocity_rmse,yaw_rate_rmse,qp_failures,sim_time,wall_time"
+            << std::endl;
+
+  auto sim_time_total = 0.0;
+  for (unsigned int i = 0; i < results.size(); i++)
+  {
+    const auto kp_scale = kp_scales.at(i / kd_scales.size());
+    const auto kd_scale = kd_scales.at(i % kd_scales.size());
+    const quadruped_simulation::RolloutResult& result = results.at(i);
+
+    std::cout << kp_scale << "," << kd_scale << "," << result.stood_up << ","
+              << result.fell << "," << result.fall_time << "," << result.position_rmse
+              << "," << result.velocity_rmse << "," << result.yaw_rate_rmse << ","
+              << result.qp_failures << "," << result.sim_time << "," << result.wall_time
+              << std::endl;
+
+    sim_time_total += result.sim_time;
+  }
+
+  std::cerr << "Rollouts: " << results.size() << " Wall time (s): " << wall_time
+            << " Sim time (s): " << sim_time_total
+            << " Speedup: " << sim_time_total / wall_time << "x" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,385 @@
+/**
+ * @file headless_rollout.cpp
+ * @date 2021-11-20
+ * @author Boston Cleek
+ * @brief Headless faster-than-real-time controller rollouts
+ */
+
+// C++
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+// Quadruped Control
+#include <quadruped_controller/balance_controller.hpp>
+#include <quadruped_controller/foot_planner.hpp>
+#include <quadruped_controller/gait.hpp>
+#include <quadruped_controller/joint_controller.hpp>
+#include <quadruped_controller/kinematics.hpp>
+#include <quadruped_controller/static_kinematics.hpp>
+#include <quadruped_controller/trajectory.hpp>
+#include <quadruped_controller/math/numerics.hpp>
+
+#include <quadruped_simulation/headless_rollout.hpp>
+#include <quadruped_simulation/plant_cache.hpp>
+
+// Drake
+#include <drake/math/rigid_transform.h>
+#include <drake/multibody/plant/multibody_plant.h>
+#include <drake/systems/analysis/simulator.h>
+
+namespace quadruped_simulation
+{
+using namespace quadruped_controller;
+
+using drake::math::RigidTransformd;
+using Eigen::Quaterniond;
+using Eigen::Vector3d;
+using Eigen::VectorXd;
+
+using math::Pose;
+using math::Quaternion;
+
+static const std::vector<std::string> leg_names = { "RL", "FL", "RR", "FR" };
+
+/** @brief Gait schedule at a gait time from the closed-form phase equations */
+static GaitMap gaitAtTime(double t, double t_stance, double t_swing, const vec& offset)
+{
+  const auto period = t_stance + t_swing;
+  const auto stance_phase = t_stance / period;
+
+  GaitMap gait_map;
+  for (unsigned int i = 0; i < NUM_LEGS; i++)
+  {
+    // wrap phase [0 1)
+    const auto phase = std::fmod(offset(i) + t / period, 1.0);
+    const auto state = (phase <= stance_phase) ? LegState::stance : LegState::swing;
+    gait_map.emplace(static_cast<LegId>(i), std::make_pair(state, phase));
+  }
+
+  return gait_map;
+}
+
+RolloutResult runRollout(const RolloutConfig& config)
+{
+  const auto wall_start = std::chrono::steady_clock::now();
+
+  // Same plant setup as the simulation interface node but without
+  // visualization or contact result publishing. The finalized diagram is
+  // shared through the template cache: every rollout in a sweep with the
+  // same scene clones a fresh context off one build, so only the first
+  // rollout pays the URDF parse and finalize cost.
+  PlantSceneConfig scene_config;
+  scene_config.urdf_path = config.urdf_path;
+  scene_config.time_step = config.time_step;
+  scene_config.static_friction = config.static_friction;
+  scene_config.dynamic_friction = config.dynamic_friction;
+  scene_config.penetration_allowance = config.penetration_allowance;
+
+  const PlantTemplate plant_template = getPlantTemplate(scene_config);
+  const drake::multibody::MultibodyPlant<double>& plant = *plant_template.plant;
+
+  std::unique_ptr<drake::systems::Context<double>> diagram_context =
+      plant_template.diagram->CreateDefaultContext();
+
+  drake::systems::Context<double>& plant_context =
+      plant_template.diagram->GetMutableSubsystemContext(plant, diagram_context.get());
+
+  const auto num_joints = static_cast<unsigned int>(config.init_joint_positions.n_elem);
+
+  const drake::systems::InputPort<double>& input_port = plant.get_actuation_input_port();
+  VectorXd tau = VectorXd::Zero(num_joints);
+  input_port.FixValue(&plant_context, tau);
+
+  // Initial joint positions
+  Eigen::VectorBlock<drake::VectorX<double>> state_vec =
+      plant_context.get_mutable_discrete_state(0).get_mutable_value();
+
+  for (unsigned int i = 0; i < num_joints; i++)
+  {
+    state_vec(7 + i) = config.init_joint_positions(i);
+  }
+
+  // Initial pose of base_link in the world
+  const drake::multibody::Body<double>& base_link =
+      plant.GetBodyByName(config.base_link_name);
+
+  const Vector3d start_position(config.init_position(0), config.init_position(1),
+                                config.init_position(2));
+  const Quaterniond start_orientation(config.init_orientation(3),
+                                      config.init_orientation(0),
+                                      config.init_orientation(1),
+                                      config.init_orientation(2));
+
+  plant.SetFreeBodyPoseInWorldFrame(&plant_context, base_link,
+                                    RigidTransformd(start_orientation, start_position));
+
+  drake::systems::Simulator simulator(*plant_template.diagram, std::move(diagram_context));
+  simulator.Initialize();
+
+  // Run as fast as the hardware allows
+  simulator.set_target_realtime_rate(0.0);
+
+  // Controller stack, one instance per rollout so sweeps are independent
+  const mat Ib = arma::diagmat(config.Ib_diagonal);
+  const mat S = arma::diagmat(config.s_diagonal);
+  const mat W = arma::eye(12, 12) * config.w_diagonal;
+
+  const BalanceController balance_controller(config.mu, config.mass, config.fzmin,
+                                             config.fzmax, Ib, S, W, config.kff,
+                                             config.kp_p, config.kd_p, config.kp_w,
+                                             config.kd_w, leg_names);
+
+  const JointController joint_controller(config.jc_kff, config.jc_kp, config.jc_kd);
+  const QuadrupedKinematics kinematics;
+  const FootPlanner foothold_planner;
+  const FootTrajectoryManager foot_traj_manager(config.foot_height, config.t_swing,
+                                                config.t_stance);
+
+  // Desired COM state starts at the standing configuration
+  mat Rwb_d = arma::eye(3, 3);
+  vec3 x_d = { 0.0, 0.0, config.standing_height };
+  vec3 xdot_d(arma::fill::zeros);
+  vec3 w_d(arma::fill::zeros);
+
+  GaitMap gait_map = make_stance_gait();
+
+  bool gait_running = false;
+  auto gait_start = 0.0;
+
+  RolloutResult result;
+
+  const auto dt_control = 1.0 / config.control_frequency;
+  const auto steps = static_cast<unsigned int>(config.duration * config.control_frequency);
+
+  auto pos_err_sq = 0.0;
+  auto vel_err_sq = 0.0;
+  auto yaw_rate_err_sq = 0.0;
+  unsigned int err_samples = 0;
+  unsigned int prev_failures = 0;
+
+  auto t = 0.0;
+  for (unsigned int k = 0; k < steps; k++)
+  {
+    const drake::VectorX<double>& state_vector =
+        simulator.get_context().get_discrete_state(0).value();
+
+    // COM state in world frame
+    const Quaternion quat(state_vector(0), state_vector(1), state_vector(2),
+                          state_vector(3));
+    const mat33 Rwb = quat.rotation().matrix();
+
+    const vec3 x = { state_vector(4), state_vector(5), state_vector(6) };
+    const vec3 w = { state_vector(7 + num_joints), state_vector(8 + num_joints),
+                     state_vector(9 + num_joints) };
+    const vec3 xdot = { state_vector(10 + num_joints), state_vector(11 + num_joints),
+                        state_vector(12 + num_joints) };
+
+    // Joint states follow the joint_states topic order
+    JointStatesMap joint_states_map;
+    for (unsigned int i = 0; i < NUM_LEGS; i++)
+    {
+      LegJointStates leg;
+      leg.q(0) = state_vector(7 + i);
+      leg.q(1) = state_vector(7 + i + 4);
+      leg.q(2) = state_vector(7 + i + 8);
+
+      leg.qdot(0) = state_vector(13 + num_joints + i);
+      leg.qdot(1) = state_vector(13 + num_joints + i + 4);
+      leg.qdot(2) = state_vector(13 + num_joints + i + 8);
+
+      joint_states_map.emplace(static_cast<LegId>(i), leg);
+    }
+
+    // FK (body frame)
+    const FootholdMap foot_actual_map = kinematics.forwardKinematics(joint_states_map);
+
+    // Standing height achieved: start the gait
+    if (!gait_running && math::almost_equal(x(2), config.standing_height, 0.005))
+    {
+      result.stood_up = true;
+      gait_running = true;
+      gait_start = t;
+    }
+
+    // Fall detection: body too low after standing or tilted too far
+    const auto tilt = std::acos(std::clamp(Rwb(2, 2), -1.0, 1.0));
+    if ((result.stood_up && x(2) < config.min_height) || (tilt > config.max_tilt))
+    {
+      result.fell = true;
+      result.fall_time = t;
+      break;
+    }
+
+    if (gait_running)
+    {
+      // Integrate the commanded twist, same as the commander loop
+      const Pose pose(Rwb, x);
+      const Pose pose_desired = integrate_twist_yaw(pose, config.twist_cmd, 0.001);
+
+      Rwb_d = pose_desired.orientation.matrix();
+      x_d = pose_desired.position;
+      x_d(2) = config.standing_height;
+
+      const vec Vw = pose.transform().adjoint() * config.twist_cmd;
+      xdot_d = Vw.rows(0, 2);
+      w_d = Vw.rows(3, 5);
+
+      // Gait phases follow sim time, not the wall clock
+      gait_map = gaitAtTime(t - gait_start, config.t_stance, config.t_swing,
+                            config.phase_offset);
+
+      // Plan footholds (world frame) for legs entering swing
+      const auto foothold_plan = foothold_planner.positions(
+          config.t_stance, Rwb, x, xdot, w, xdot_d, foot_actual_map, gait_map);
+
+      if (std::get<bool>(foothold_plan))
+      {
+        const FootholdMap foothold_final_map = std::get<FootholdMap>(foothold_plan);
+
+        FootTrajBoundsMap foot_traj_bounds_map;
+        for (const auto& [leg_name, p_final] : foothold_final_map)
+        {
+          const vec3 p_start = Rwb * foot_actual_map.at(leg_name) + x;
+          foot_traj_bounds_map.emplace(leg_name, FootTrajBounds(p_start, p_final));
+        }
+
+        foot_traj_manager.referenceStates(gait_map, foot_traj_bounds_map);
+      }
+      else
+      {
+        foot_traj_manager.referenceStates(gait_map);
+      }
+    }
+
+    // Swing leg reference joint states
+    JointStatesMap swing_leg_js_map;
+    for (const auto& [leg_name, leg_state] : gait_map)
+    {
+      if (leg_state.first == LegState::swing)
+      {
+        FootState foot_state =
+            foot_traj_manager.referenceState(leg_name, gait_map.at(leg_name).second);
+
+        // Transform foot state into body frame for IK and J^-1
+        foot_state.position = Rwb.t() * foot_state.position - x;
+        foot_state.velocity = Rwb.t() * foot_state.velocity;
+
+        const vec3 q =
+            RobotKinematics::legInverseKinematics(leg_id(leg_name), foot_state.position);
+        const vec3 qdot =
+            RobotKinematics::legJacobianInverse(leg_id(leg_name), q) * foot_state.velocity;
+
+        swing_leg_js_map.emplace(leg_name, LegJointStates(q, qdot));
+      }
+    }
+
+    // Leg swing control
+    const TorqueMap swing_torque_map =
+        joint_controller.control(swing_leg_js_map, joint_states_map);
+
+    // Optimize GRF for stance legs
+    const ForceMap force_map = balance_controller.control(Rwb, Rwb_d, x, xdot, w, x_d,
+                                                          xdot_d, w_d, foot_actual_map,
+                                                          gait_map);
+
+    // consecutiveFailures() resets after a successful solve: count the
+    // increments to total the failed solves over the rollout
+    const auto failures = balance_controller.consecutiveFailures();
+    if (failures > prev_failures)
+    {
+      result.qp_failures += failures - prev_failures;
+    }
+    prev_failures = failures;
+
+    // Only use for stance legs
+    TorqueMap torque_map = kinematics.jacobianTransposeControl(joint_states_map, force_map);
+
+    // Merge torque maps
+    torque_map.insert(swing_torque_map.begin(), swing_torque_map.end());
+
+    // Apply clamped torques in the canonical actuator order [RL FL RR FR]
+    tau.setZero();
+    for (const auto& [leg_name, torque] : torque_map)
+    {
+      const auto offset = static_cast<unsigned int>(leg_id(leg_name)) * 3;
+      const vec3 tau_leg = arma::clamp(torque, config.tau_min, config.tau_max);
+
+      tau(offset) = tau_leg(0);
+      tau(offset + 1) = tau_leg(1);
+      tau(offset + 2) = tau_leg(2);
+    }
+
+    input_port.FixValue(&plant_context, tau);
+
+    // Tracking error once the gait is running
+    if (gait_running)
+    {
+      pos_err_sq += arma::dot(x - x_d, x - x_d);
+      vel_err_sq += arma::dot(xdot - xdot_d, xdot - xdot_d);
+      yaw_rate_err_sq += (w(2) - w_d(2)) * (w(2) - w_d(2));
+      err_samples++;
+    }
+
+    t += dt_control;
+    simulator.AdvanceTo(t);
+  }
+
+  result.sim_time = t;
+
+  if (err_samples > 0)
+  {
+    const auto n = static_cast<double>(err_samples);
+    result.position_rmse = std::sqrt(pos_err_sq / n);
+    result.velocity_rmse = std::sqrt(vel_err_sq / n);
+    result.yaw_rate_rmse = std::sqrt(yaw_rate_err_sq / n);
+  }
+
+  result.wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                   wall_start)
+                         .count();
+
+  return result;
+}
+
+std::vector<RolloutResult> runRollouts(const std::vector<RolloutConfig>& configs,
+                                       unsigned int num_threads)
+{
+  std::vector<RolloutResult> results(configs.size());
+
+  auto workers =
+      (num_threads > 0) ? num_threads : std::thread::hardware_concurrency();
+  workers = std::max(1u, std::min(workers, static_cast<unsigned int>(configs.size())));
+
+  // Workers pull the next unclaimed rollout until the sweep is done
+  std::atomic<unsigned int> next = 0;
+
+  std::vector<std::thread> pool;
+  pool.reserve(workers);
+
+  for (unsigned int i = 0; i < workers; i++)
+  {
+    pool.emplace_back([&] {
+      while (true)
+      {
+        const auto index = next.fetch_add(1);
+        if (index >= configs.size())
+        {
+          break;
+        }
+
+        results.at(index) = runRollout(configs.at(index));
+      }
+    });
+  }
+
+  for (auto& worker : pool)
+  {
+    worker.join();
+  }
+
+  return results;
+}
+}  // namespace quadruped_simulation
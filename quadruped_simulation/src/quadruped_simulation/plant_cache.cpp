@@ -0,0 +1,144 @@
+/**
+ * @file plant_cache.cpp
+ * @date 2021-11-27
+ * @author Boston Cleek
+ * @brief Process-wide cache of finalized Drake plant diagrams
+ */
+
+// C++
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#include <quadruped_simulation/plant_cache.hpp>
+
+// Drake
+#include <drake/geometry/drake_visualizer.h>
+#include <drake/geometry/scene_graph.h>
+#include <drake/math/rigid_transform.h>
+#include <drake/multibody/parsing/parser.h>
+#include <drake/multibody/plant/contact_results_to_lcm.h>
+#include <drake/systems/framework/diagram_builder.h>
+
+namespace quadruped_simulation
+{
+using drake::math::RigidTransformd;
+
+/** @brief FNV-1a accumulation of a byte string into a running hash */
+static uint64_t hashBytes(uint64_t hash, const std::string& bytes)
+{
+  for (const auto byte : bytes)
+  {
+    hash ^= static_cast<uint64_t>(static_cast<unsigned char>(byte));
+    hash *= 1099511628211ull;
+  }
+
+  return hash;
+}
+
+/**
+ * @brief Hash the scene description
+ * @param config - scene description
+ * @return cache key
+ * @details The URDF is hashed by contents rather than path so editing the
+ * robot description invalidates the cached build. The physics parameters
+ * are folded in through their exact text representation.
+ */
+static uint64_t sceneKey(const PlantSceneConfig& config)
+{
+  auto hash = 14695981039346656037ull;  // FNV offset basis
+
+  std::ifstream urdf(config.urdf_path);
+  if (urdf.is_open())
+  {
+    std::stringstream contents;
+    contents << urdf.rdbuf();
+    hash = hashBytes(hash, contents.str());
+  }
+  else
+  {
+    // Let the parser report the missing file, key on the path meanwhile
+    hash = hashBytes(hash, config.urdf_path);
+  }
+
+  std::stringstream parameters;
+  parameters << config.time_step << " " << config.static_friction << " "
+             << config.dynamic_friction << " " << config.penetration_allowance << " "
+             << config.visualize;
+
+  return hashBytes(hash, parameters.str());
+}
+
+/** @brief Parse, assemble, and finalize the scene diagram */
+static PlantTemplate buildPlantTemplate(const PlantSceneConfig& config)
+{
+  drake::systems::DiagramBuilder<double> builder;
+
+  // Adds a MultibodyPlant and a SceneGraph instance to a diagram builder,
+  // connecting the geometry ports.
+  auto pair = drake::multibody::AddMultibodyPlantSceneGraph(
+      &builder,
+      std::make_unique<drake::multibody::MultibodyPlant<double>>(config.time_step));
+
+  drake::multibody::MultibodyPlant<double>& plant = pair.plant;
+
+  // Parses SDF and URDF input files into a MultibodyPlant and (optionally) a SceneGraph.
+  drake::multibody::Parser(&plant).AddModelFromFile(config.urdf_path);
+
+  if (config.visualize)
+  {
+    // Ground plane color
+    const drake::Vector4<double> green(0.5, 1.0, 0.5, 1.0);
+    plant.RegisterVisualGeometry(plant.world_body(), RigidTransformd(),
+                                 drake::geometry::HalfSpace(), "GroundVisualGeometry",
+                                 green);
+  }
+
+  plant.set_penetration_allowance(config.penetration_allowance);
+
+  // For a time-stepping model only static friction is used.
+  const drake::multibody::CoulombFriction<double> ground_friction(
+      config.static_friction, config.dynamic_friction);
+
+  plant.RegisterCollisionGeometry(plant.world_body(), RigidTransformd(),
+                                  drake::geometry::HalfSpace(), "GroundCollisionGeometry",
+                                  ground_friction);
+
+  // This method must be called after all elements in the model
+  // (joints, bodies, force elements, constraints, etc.) are added
+  // and before any computations are performed.
+  plant.Finalize();
+
+  if (config.visualize)
+  {
+    // Publish contact results and geometry to drake_visualizer.
+    drake::multibody::ConnectContactResultsToDrakeVisualizer(&builder, plant);
+    drake::geometry::DrakeVisualizerd::AddToBuilder(&builder, pair.scene_graph);
+  }
+
+  PlantTemplate plant_template;
+  plant_template.diagram = builder.Build();
+  plant_template.plant = &plant;
+
+  return plant_template;
+}
+
+PlantTemplate getPlantTemplate(const PlantSceneConfig& config)
+{
+  static std::mutex cache_mutex;
+  static std::map<uint64_t, PlantTemplate> cache;
+
+  const auto key = sceneKey(config);
+
+  const std::scoped_lock lock(cache_mutex);
+  const auto search = cache.find(key);
+  if (search != cache.end())
+  {
+    return search->second;
+  }
+
+  return cache.emplace(key, buildPlantTemplate(config)).first->second;
+}
+}  // namespace quadruped_simulation